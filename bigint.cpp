@@ -1,8 +1,13 @@
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
 #include "bigint.h"
+#include "bigint_limbs.h"
 
 BigInt::BigInt()
 {
@@ -14,6 +19,7 @@ BigInt::BigInt(uint64_t val, bool negative)
 {
   nums.push_back(val);
   this->negative = negative;
+  normalize();
 }
 
 BigInt::BigInt(std::initializer_list<uint64_t> vals, bool negative)
@@ -22,72 +28,81 @@ BigInt::BigInt(std::initializer_list<uint64_t> vals, bool negative)
     nums.push_back(*i);
   }
   this->negative = negative;
+  normalize();
+}
+
+BigInt::BigInt(LimbSpan vals, bool negative)
+{
+  nums.resize(vals.size());
+  std::copy(vals.begin(), vals.end(), nums.data());
+  this->negative = negative;
+  normalize();
 }
 
 BigInt::BigInt(const BigInt &other)
 {
-  nums = other.get_bit_vector();
+  nums = other.nums;
   this->negative = other.is_negative();
 }
 
+BigInt::BigInt(BigInt &&other) noexcept
+  : nums(std::move(other.nums)), negative(other.negative)
+{
+  // the moved-from limb vector is empty and inline, so this can't throw
+  other.nums.push_back(0);
+  other.negative = false;
+}
+
 BigInt::~BigInt()
 {
 }
 
 BigInt &BigInt::operator=(const BigInt &rhs)
 {
-  this->nums = rhs.get_bit_vector();
+  this->nums = rhs.nums;
   this->negative = rhs.is_negative();
   return *this;
 }
 
+BigInt &BigInt::operator=(BigInt &&rhs) noexcept
+{
+  if (this != &rhs) {
+    this->nums = std::move(rhs.nums);
+    this->negative = rhs.negative;
+    rhs.nums.push_back(0);
+    rhs.negative = false;
+  }
+  return *this;
+}
+
 bool BigInt::is_negative() const
 {
   return negative;
 }
 
-const std::vector<uint64_t> &BigInt::get_bit_vector() const {
-  return nums;
+LimbSpan BigInt::get_bit_vector() const {
+  return nums.view();
 }
 
 uint64_t BigInt::get_bits(unsigned index) const
 {
-  try {
-    return nums.at(index);
-  } catch (...) {
-    return 0;
-  }
-
+  return index < nums.size() ? nums[index] : 0;
 }
 
 BigInt BigInt::operator+(const BigInt &rhs) const
 {
-  BigInt res;
-  if (this->negative != rhs.negative) {
-    if (this->compare_magnitudes(rhs) >= 0) {
-        res = this->subtract_magnitudes(rhs);
-        res.negative = this->negative; 
-    } else {
-        res = rhs.subtract_magnitudes(*this);
-        res.negative = rhs.negative; 
-    }
-      return res;
-  } else {
-    res = this->add_magnitudes(rhs); 
-    res.negative = this->negative; 
-  }
-  return res; 
+  return shifted_sum(*this, rhs, false, 0);
 }
 
 BigInt BigInt::operator-(const BigInt &rhs) const
 {
-  return *this + -rhs;
+  return shifted_sum(*this, rhs, true, 0);
 }
 
 BigInt BigInt::operator-() const
 {
-  BigInt to_return = *(new BigInt(*this));
-  if (to_return.to_hex() != "0") {
+  BigInt to_return(*this);
+  if (!to_return.is_zero()) {
     to_return.negative = !to_return.is_negative();
   }
   return to_return;
@@ -106,91 +121,423 @@ bool BigInt::is_bit_set(unsigned n) const
 
 BigInt BigInt::operator<<(unsigned n) const
 {
+  if (negative) {
+    throw std::invalid_argument("left shift of a negative value");
+  }
+
+  size_t shift_chunks = n / 64;
+  unsigned shift_bits = n % 64;
+  size_t size = nums.size();
+
   BigInt res;
-  unsigned shift_chunks = n / 64;
+  res.nums.resize(size + shift_chunks + 1);
+  uint64_t *limbs = res.nums.data();
+  if (shift_bits != 0) {
+    limbs[shift_chunks + size] = limbs_lshift(limbs + shift_chunks, nums.data(), size, shift_bits);
+  } else {
+    memcpy(limbs + shift_chunks, nums.data(), size * sizeof(uint64_t));
+  }
+
+  res.normalize();
+  return res;
+}
+
+BigInt BigInt::add_lshift(const BigInt &rhs, unsigned n) const
+{
+  return shifted_sum(*this, rhs, false, n);
+}
+
+BigInt BigInt::sub_lshift(const BigInt &rhs, unsigned n) const
+{
+  return shifted_sum(*this, rhs, true, n);
+}
+
+BigInt BigInt::operator>>(unsigned n) const
+{
+  BigInt res(*this);
+  res >>= n;
+  return res;
+}
+
+BigInt BigInt::operator&(const BigInt &rhs) const
+{
+  BigInt res(*this);
+  res &= rhs;
+  return res;
+}
+
+BigInt BigInt::operator|(const BigInt &rhs) const
+{
+  BigInt res(*this);
+  res |= rhs;
+  return res;
+}
+
+BigInt BigInt::operator^(const BigInt &rhs) const
+{
+  BigInt res(*this);
+  res ^= rhs;
+  return res;
+}
+
+BigInt BigInt::operator~() const
+{
+  BigInt res = -*this;
+  res -= BigInt(1);
+  return res;
+}
+
+BigInt BigInt::operator*(const BigInt &rhs) const
+{
+  return product(*this, rhs);
+}
+
+BigInt BigInt::square() const
+{
+  return product(*this, *this);
+}
+
+BigInt BigInt::operator/(const BigInt &rhs) const
+{
+  BigInt quotient;
+  divide(rhs, &quotient, nullptr);
+  return quotient;
+}
+
+BigInt BigInt::operator%(const BigInt &rhs) const
+{
+  BigInt remainder;
+  divide(rhs, nullptr, &remainder);
+  return remainder;
+}
+
+std::pair<BigInt, BigInt> BigInt::divmod(const BigInt &rhs) const
+{
+  std::pair<BigInt, BigInt> result;
+  divide(rhs, &result.first, &result.second);
+  return result;
+}
+
+BigInt &BigInt::operator+=(const BigInt &rhs)
+{
+  add_in_place(rhs, rhs.negative);
+  return *this;
+}
+
+BigInt &BigInt::operator-=(const BigInt &rhs)
+{
+  add_in_place(rhs, !rhs.negative);
+  return *this;
+}
+
+BigInt &BigInt::addmul(const BigInt &a, const BigInt &b)
+{
+  add_product_in_place(a, b, false);
+  return *this;
+}
+
+BigInt &BigInt::submul(const BigInt &a, const BigInt &b)
+{
+  add_product_in_place(a, b, true);
+  return *this;
+}
+
+BigInt &BigInt::operator*=(const BigInt &rhs)
+{
+  if (this->is_zero() || rhs.is_zero()) {
+    nums.clear();
+    nums.push_back(0);
+    negative = false;
+    return *this;
+  }
+
+  size_t an = nums.size(), bn = rhs.nums.size();
+  bool product_negative = this->negative != rhs.negative;
+  bool squaring = &rhs == this || compare_magnitudes(rhs) == 0;
+
+  // the product can't overlap its operands, so this value's limbs are
+  // set aside: copied if the product fits in the current storage,
+  // otherwise moved out (and fresh storage allocated for the product)
+  LimbVector a = nums.capacity() >= an + bn ? LimbVector(nums) : LimbVector(std::move(nums));
+  // passing the same limbs twice makes limbs_mul square them
+  const LimbVector &b = squaring ? a : rhs.nums;
+
+  nums.resize(an + bn);
+  if (an >= bn) {
+    limbs_mul(nums.data(), a.data(), an, b.data(), bn);
+  } else {
+    limbs_mul(nums.data(), b.data(), bn, a.data(), an);
+  }
+  negative = product_negative;
+  normalize();
+  return *this;
+}
+
+BigInt &BigInt::operator<<=(unsigned n)
+{
+  if (negative) {
+    throw std::invalid_argument("left shift of a negative value");
+  }
+
+  size_t shift_chunks = n / 64;
+  unsigned shift_bits = n % 64;
+  size_t size = nums.size();
+
+  nums.resize(size + shift_chunks + 1);
+  uint64_t *limbs = nums.data();
+  if (shift_bits != 0) {
+    limbs[shift_chunks + size] = limbs_lshift(limbs + shift_chunks, limbs, size, shift_bits);
+  } else if (shift_chunks != 0) {
+    memmove(limbs + shift_chunks, limbs, size * sizeof(uint64_t));
+  }
+  memset(limbs, 0, shift_chunks * sizeof(uint64_t));
+
+  normalize();
+  return *this;
+}
+
+BigInt &BigInt::operator>>=(unsigned n)
+{
+  size_t shift_chunks = n / 64;
   unsigned shift_bits = n % 64;
-  uint64_t carry = 0;
+  size_t size = nums.size();
 
-  res.nums.resize(nums.size() + shift_chunks, 0);
+  if (shift_chunks >= size) {
+    // every bit is shifted out: 0, or -1 for a negative value
+    nums.clear();
+    nums.push_back(negative ? 1 : 0);
+    return *this;
+  }
 
-  for (size_t i = 0; i < nums.size(); ++i) {
-    uint64_t shifted_chunk = nums[i] << shift_bits;
+  // a negative value whose shifted-out bits aren't all zero has to be
+  // rounded down, i.e., its magnitude rounded up
+  uint64_t *limbs = nums.data();
+  bool inexact = false;
+  for (size_t i = 0; i < shift_chunks && !inexact; ++i) {
+    inexact = limbs[i] != 0;
+  }
 
-    res.nums[i + shift_chunks] |= (shifted_chunk | carry);
+  size_t rest = size - shift_chunks;
+  if (shift_bits != 0) {
+    inexact |= limbs_rshift(limbs, limbs + shift_chunks, rest, shift_bits) != 0;
+  } else if (shift_chunks != 0) {
+    memmove(limbs, limbs + shift_chunks, rest * sizeof(uint64_t));
+  }
+  nums.resize(rest);
 
-    carry = (nums[i] >> (64 - shift_bits));
+  if (negative && inexact) {
+    uint64_t carry = limbs_add_1(nums.data(), nums.data(), rest, 1);
+    if (carry != 0) {
+      nums.push_back(carry);
     }
-
-  if (carry != 0) {
-      res.nums.push_back(carry);
   }
 
-  return res; 
+  normalize();
+  return *this;
 }
 
-BigInt BigInt::operator*(const BigInt &rhs) const
+template <typename Op>
+void BigInt::bitwise_in_place(const BigInt &rhs, Op op)
 {
-  BigInt product = BigInt(); 
-  product.negative = this->negative != rhs.negative;
+  if (&rhs == this) {
+    BigInt copy(rhs);
+    bitwise_in_place(copy, op);
+    return;
+  }
 
-  const BigInt& pos_lhs = this->negative ? -*this : *this;
-  const BigInt& pos_rhs = rhs.negative ? -rhs : rhs;
+  // The operands are combined as two's complement values one limb
+  // longer than the longer of them, so that the top limb of each is
+  // pure sign extension and so is the top limb of the result.
+  size_t bn = rhs.nums.size();
+  size_t n = std::max(nums.size(), bn) + 1;
+  bool result_negative = op(negative ? ~0UL : 0, rhs.negative ? ~0UL : 0) != 0;
 
-  for (int i = 0; i < pos_rhs.nums.size() * 64; i++)
-  {
-    if (pos_rhs.is_bit_set(i)) {
-        product = product + (pos_lhs << i);
+  nums.resize(n);
+  uint64_t *rp = nums.data();
+  const uint64_t *bp = rhs.nums.data();
+  if (negative) {
+    limbs_negate(rp, n);
+  }
+
+  // rhs is negated on the fly: below its lowest non-zero limb, -b is
+  // zero (like b); that limb is negated, and all limbs above it are
+  // complemented. Each loop is a plain pass over the limbs, which the
+  // compiler can vectorize.
+  size_t i = 0;
+  if (rhs.negative) {
+    size_t low = 0;
+    while (bp[low] == 0) {
+      ++low;
+    }
+    for (; i < low; ++i) {
+      rp[i] = op(rp[i], 0);
+    }
+    rp[i] = op(rp[i], -bp[i]);
+    for (++i; i < bn; ++i) {
+      rp[i] = op(rp[i], ~bp[i]);
+    }
+    for (; i < n; ++i) {
+      rp[i] = op(rp[i], ~0UL);
+    }
+  } else {
+    for (; i < bn; ++i) {
+      rp[i] = op(rp[i], bp[i]);
+    }
+    for (; i < n; ++i) {
+      rp[i] = op(rp[i], 0);
     }
   }
 
-  return product;
+  negative = result_negative;
+  if (negative) {
+    limbs_negate(rp, n);
+  }
+  normalize();
 }
 
-BigInt BigInt::operator/(const BigInt &rhs) const
+BigInt &BigInt::operator&=(const BigInt &rhs)
 {
-  if (rhs.compare_magnitudes(*this) > 0) {
-    return BigInt();
+  bitwise_in_place(rhs, [](uint64_t a, uint64_t b) { return a & b; });
+  return *this;
+}
+
+BigInt &BigInt::operator|=(const BigInt &rhs)
+{
+  bitwise_in_place(rhs, [](uint64_t a, uint64_t b) { return a | b; });
+  return *this;
+}
+
+BigInt &BigInt::operator^=(const BigInt &rhs)
+{
+  bitwise_in_place(rhs, [](uint64_t a, uint64_t b) { return a ^ b; });
+  return *this;
+}
+
+BigInt &BigInt::operator/=(const BigInt &rhs)
+{
+  BigInt quotient;
+  divide(rhs, &quotient, nullptr);
+  return *this = std::move(quotient);
+}
+
+BigInt &BigInt::operator%=(const BigInt &rhs)
+{
+  BigInt remainder;
+  divide(rhs, nullptr, &remainder);
+  return *this = std::move(remainder);
+}
+
+BigInt BigInt::modpow(const BigInt &exp, const BigInt &mod) const
+{
+  if (exp.negative) {
+    throw std::invalid_argument("negative exponent");
+  }
+  if (mod.negative || mod.is_zero()) {
+    throw std::invalid_argument("modulus must be positive");
   }
-  
-  BigInt pos_this = *this;
-  pos_this.negative = false;
-  BigInt pos_rhs = rhs;
-  pos_rhs.negative = false;
 
-  BigInt low(0);
-  BigInt high(*this);
+  // a negative base is replaced by its (non-negative) residue
+  const BigInt *base = this;
+  BigInt residue;
+  if (negative) {
+    residue = *this % mod;
+    residue += mod;
+    base = &residue;
+  }
 
-  while (low <= high) {
-    BigInt mid = (low + high) / 2;
-    BigInt product = mid * pos_rhs;
+  size_t n = mod.nums.size();
+  BigInt res;
+  res.nums.resize(n);
+  limbs_powm(res.nums.data(), base->nums.data(), base->nums.size(),
+             exp.nums.data(), exp.nums.size(), mod.nums.data(), n);
+  res.normalize();
+  return res;
+}
+
+BigInt BigInt::pow(uint64_t exp) const
+{
+  if (exp == 0) {
+    return BigInt(1);
+  }
+  if (is_zero() || exp == 1) {
+    return *this;
+  }
 
-    int cmp = product.compare_magnitudes(pos_this);
+  // |this| = odd * 2^t: the power of the odd part is computed, and
+  // 2^(t*exp) applied as a shift
+  size_t n = nums.size();
+  size_t low = 0;
+  while (nums[low] == 0) {
+    ++low;
+  }
+  unsigned low_bits = __builtin_ctzll(nums[low]);
+  size_t t = 64 * low + low_bits;
+  size_t bits = 64 * n - __builtin_clzll(nums[n - 1]) - t;
+  std::vector<uint64_t> odd(n - low);
+  if (low_bits != 0) {
+    limbs_rshift(odd.data(), nums.data() + low, n - low, low_bits);
+  } else {
+    memcpy(odd.data(), nums.data() + low, (n - low) * sizeof(uint64_t));
+  }
+  size_t on = limbs_normalized_size(odd.data(), n - low);
 
-    if (cmp == 0) {
-      if (this->negative != rhs.negative) {
-        mid.negative = true;
+  if (exp > (SIZE_MAX / 2) / (bits + t) || t * exp > UINT_MAX) {
+    throw std::invalid_argument("power too large");
+  }
+  unsigned shift = (unsigned) (t * exp);
+
+  // odd^exp has at most bits*exp bits (or is 1); every intermediate
+  // square or product fits in that plus a limb. The two buffers take
+  // turns as the destination; the result's own storage also has room
+  // for the final shift.
+  size_t rn = bits > 1 ? bits * exp / 64 + 2 : 1;
+  BigInt res;
+  res.nums.reserve(rn + shift / 64 + 1);
+  res.nums.resize(rn);
+  std::vector<uint64_t> tmp(rn);
+  uint64_t *cur = res.nums.data(), *other = tmp.data();
+  memcpy(cur, odd.data(), on * sizeof(uint64_t));
+  size_t cn = on;
+  if (bits > 1) {
+    for (int bit = 62 - __builtin_clzll(exp); bit >= 0; --bit) {
+      limbs_sqr(other, cur, cn);
+      cn = limbs_normalized_size(other, 2 * cn);
+      std::swap(cur, other);
+      if ((exp >> bit) & 1) {
+        if (on == 1) {
+          uint64_t carry = limbs_mul_1(cur, cur, cn, odd[0]);
+          if (carry != 0) {
+            cur[cn++] = carry;
+          }
+        } else {
+          limbs_mul(other, cur, cn, odd.data(), on);
+          cn = limbs_normalized_size(other, cn + on);
+          std::swap(cur, other);
+        }
       }
-      return mid;
-    } else if (cmp < 0) {
-      low = mid + 1;
-    } else if (cmp > 0) {
-      high = mid - 1;
     }
   }
+  if (cur != res.nums.data()) {
+    memcpy(res.nums.data(), cur, cn * sizeof(uint64_t));
+  }
+  res.nums.resize(cn);
 
-  if (this->negative != rhs.negative) {
-    low.negative = true;
+  if (shift != 0) {
+    res <<= shift;
   }
-  
-  return low;
+  res.negative = negative && (exp & 1);
+  return res;
 }
 
 int BigInt::compare(const BigInt &rhs) const
 {
-  bool reverse = this->negative != rhs.negative;
+  if (this->negative != rhs.negative) {
+    return this->negative ? -1 : 1;
+  }
+
   int magnitude_comparison = this->compare_magnitudes(rhs);
 
-  return reverse ? -magnitude_comparison : magnitude_comparison;
+  return this->negative ? -magnitude_comparison : magnitude_comparison;
 }
 
 std::string BigInt::to_hex() const
@@ -199,118 +546,277 @@ std::string BigInt::to_hex() const
   if (negative) {
     val_stream << "-";
   }
-  for (auto i = nums.end(); i != nums.begin() - 1; --i) {
-    if (val_stream.str() != "" && val_stream.str() != "-") {
-      val_stream << std::setfill('0') << std::setw(16);
-    }
-    if (*i != 0) {
-      val_stream << std::hex << *i;
-    } else if (i != nums.end() && val_stream.str() != "") {
-      val_stream << 0;
-    }
-  }
-  if (val_stream.str() == "") {
-    val_stream << 0;
+
+  // most significant limb without padding, the rest zero-filled
+  val_stream << std::hex << nums.back();
+  for (size_t i = nums.size() - 1; i > 0; --i) {
+    val_stream << std::setfill('0') << std::setw(16) << nums[i - 1];
   }
   return val_stream.str();
 }
 
 std::string BigInt::to_dec() const
 {
-  BigInt current = *this; 
   std::string res;
+  if (negative) {
+    res.push_back('-');
+  }
+  limbs_to_dec(res, nums.data(), nums.size());
+  return res;
+}
 
-  for (auto it = current.nums.rbegin(); it != current.nums.rend(); ++it) {
-    uint64_t carry = *it;
-
-    for (int i = 0; i < 64; ++i) {
-      uint64_t quotient = carry / 10;
-      uint64_t remainder = carry % 10;
+BigInt BigInt::from_dec(std::string_view str)
+{
+  bool negative = !str.empty() && str[0] == '-';
+  if (negative) {
+    str.remove_prefix(1);
+  }
+  if (str.empty()) {
+    throw std::invalid_argument("empty decimal string");
+  }
 
-      res = std::to_string(remainder) + res;
-      carry = quotient;
-      if (carry == 0 && it == current.nums.rbegin() + 1 && i < 63) {
-        break;
-      }
-    }
+  BigInt res;
+  res.nums.resize((str.size() + 18) / 19);
+  if (!limbs_from_dec(res.nums.data(), str.data(), str.size())) {
+    throw std::invalid_argument("invalid decimal string");
   }
+  res.negative = negative;
+  res.normalize();
+  return res;
+}
 
+BigInt BigInt::from_hex(std::string_view str)
+{
+  bool negative = !str.empty() && str[0] == '-';
   if (negative) {
-    res = "-" + res;
+    str.remove_prefix(1);
+  }
+  if (str.empty()) {
+    throw std::invalid_argument("empty hexadecimal string");
   }
 
+  BigInt res;
+  res.nums.resize((str.size() + 15) / 16);
+  if (!limbs_from_hex(res.nums.data(), str.data(), str.size())) {
+    throw std::invalid_argument("invalid hexadecimal string");
+  }
+  res.negative = negative;
+  res.normalize();
   return res;
 }
 
-int BigInt::compare_magnitude(const BigInt &rhs) const
+int BigInt::compare_magnitudes(const BigInt &rhs) const
 {
   if (this->nums.size() < rhs.nums.size()) {
       return -1;
   } else if (this->nums.size() > rhs.nums.size()) {
       return 1;
   } else {
-      for (size_t i = this->nums.size(); i > 0; --i) {
-          if (this->nums[i - 1] < rhs.nums[i - 1]) {
-              return -1;
-          } else if (this->nums[i - 1] > rhs.nums[i - 1]) {
-              return 1;
-          }
-      }
-      return 0;
+      return limbs_cmp(this->nums.data(), rhs.nums.data(), this->nums.size());
   }
 }
 
-BigInt BigInt::add_magnitudes(const BigInt &rhs) const
+BigInt BigInt::shifted_sum(const BigInt &a, const BigInt &b, bool subtract, unsigned n)
 {
+  // work out which magnitude is subtracted from which (if any) and
+  // the sign of the result before touching the limbs
+  const BigInt *big = &a, *small = &b;
+  bool b_negative = b.negative != subtract;
+  bool add = a.negative == b_negative;
+  bool res_negative = a.negative;
+  if (add) {
+    if (a.nums.size() < b.nums.size()) {
+      std::swap(big, small);
+    }
+  } else {
+    int cmp = a.compare_magnitudes(b);
+    if (cmp < 0) {
+      std::swap(big, small);
+      res_negative = b_negative;
+    } else if (cmp == 0) {
+      res_negative = false;
+    }
+  }
+  if (res_negative && n != 0) {
+    throw std::invalid_argument("left shift of a negative value");
+  }
+
+  size_t shift_chunks = n / 64;
+  size_t size = big->nums.size();
+
   BigInt res;
-  uint64_t carry = 0;
-  size_t max_size = std::max(this->nums.size(), rhs.nums.size());
+  res.nums.resize(shift_chunks + size + 1);
+  uint64_t *rp = res.nums.data() + shift_chunks;
+  if (add) {
+    rp[size] = limbs_add_lshift(rp, big->nums.data(), size, small->nums.data(), small->nums.size(), n % 64);
+  } else {
+    rp[size] = limbs_sub_lshift(rp, big->nums.data(), size, small->nums.data(), small->nums.size(), n % 64);
+  }
+  res.negative = res_negative;
+  res.normalize();
+  return res;
+}
 
-  for (size_t i = 0; i < max_size; ++i) {
-      uint64_t sum_result = carry;
-      if (i < this->nums.size()) {
-          sum_result += this->nums[i];
-      }
-      if (i < rhs.nums.size()) {
-          sum_result += rhs.nums[i];
-      }
+BigInt BigInt::product(const BigInt &a, const BigInt &b)
+{
+  if (a.is_zero() || b.is_zero()) {
+    return BigInt();
+  }
 
-      carry = sum_result >> 64;
+  BigInt res;
+  res.nums.resize(a.nums.size() + b.nums.size());
+  if (&a == &b || a.compare_magnitudes(b) == 0) {
+    // equal magnitudes are squared
+    limbs_sqr(res.nums.data(), a.nums.data(), a.nums.size());
+  } else {
+    // limbs_mul wants the longer operand first
+    const BigInt &big = a.nums.size() >= b.nums.size() ? a : b;
+    const BigInt &small = a.nums.size() >= b.nums.size() ? b : a;
+    limbs_mul(res.nums.data(), big.nums.data(), big.nums.size(),
+              small.nums.data(), small.nums.size());
+  }
+  res.negative = a.negative != b.negative;
+  res.normalize();
+  return res;
+}
 
-      res.nums.push_back(sum_result & UINT64_MAX);
+void BigInt::add_product_in_place(const BigInt &a, const BigInt &b, bool subtract)
+{
+  if (a.is_zero() || b.is_zero()) {
+    return;
+  }
+  if (&a == this || &b == this) {
+    BigInt prod = product(a, b);
+    add_in_place(prod, prod.negative != subtract);
+    return;
   }
 
-  if (carry != 0) {
-      res.nums.push_back(carry);
+  const BigInt &big = a.nums.size() >= b.nums.size() ? a : b;
+  const BigInt &small = a.nums.size() >= b.nums.size() ? b : a;
+  size_t bn = big.nums.size(), sn = small.nums.size();
+  bool product_negative = (a.negative != b.negative) != subtract;
+  if (is_zero()) {
+    negative = product_negative;
   }
 
-  return res;
+  // one extra limb, so that adding can't carry out of the result
+  size_t rn = std::max(nums.size(), bn + sn) + 1;
+  nums.resize(rn);
+  if (negative == product_negative) {
+    limbs_addmul(nums.data(), rn, big.nums.data(), bn, small.nums.data(), sn);
+  } else if (limbs_submul(nums.data(), rn, big.nums.data(), bn, small.nums.data(), sn) != 0) {
+    // the product was the larger: the difference is in two's complement
+    limbs_negate(nums.data(), rn);
+    negative = product_negative;
+  }
+  normalize();
 }
 
-BigInt BigInt::subtract_magnitudes(const BigInt &rhs) const
+void BigInt::add_in_place(const BigInt &rhs, bool rhs_negative)
 {
-  BigInt res;
-  uint64_t borrow = 0;
+  size_t an = nums.size(), bn = rhs.nums.size();
 
-  for (size_t i = 0; i < this->nums.size(); ++i) {
-      uint64_t sub_result = this->nums[i] - borrow;
-      if (i < rhs.nums.size()) {
-          sub_result -= rhs.nums[i];
-      }
+  if (this->negative == rhs_negative) {
+    // |this| += |rhs|, padding this value to the length of rhs first
+    if (an < bn) {
+      nums.resize(bn);
+      an = bn;
+    }
+    uint64_t carry = limbs_add(nums.data(), nums.data(), an, rhs.nums.data(), bn);
+    if (carry != 0) {
+      nums.push_back(carry);
+    }
+  } else if (this->compare_magnitudes(rhs) >= 0) {
+    // |this| -= |rhs|, keeping the sign of this value
+    limbs_sub(nums.data(), nums.data(), an, rhs.nums.data(), bn);
+  } else {
+    // |this| = |rhs| - |this|, taking the sign of rhs
+    nums.resize(bn);
+    limbs_sub_n(nums.data(), rhs.nums.data(), nums.data(), bn);
+    negative = rhs_negative;
+  }
 
-      borrow = (sub_result > this->nums[i]) ? 1 : 0;
+  normalize();
+}
 
-      res.nums.push_back(sub_result);
+void BigInt::divide(const BigInt &rhs, BigInt *quotient, BigInt *remainder) const
+{
+  if (rhs.is_zero()) {
+    throw std::invalid_argument("division by zero");
+  }
+  if (this->compare_magnitudes(rhs) < 0) {
+    if (remainder) {
+      *remainder = *this;
+    }
+    if (quotient) {
+      *quotient = BigInt();
+    }
+    return;
   }
 
-  while (!res.nums.empty() && res.nums.back() == 0) {
-      res.nums.pop_back();
+  // the results are built separately, since quotient or remainder may
+  // alias this object or rhs
+  size_t nn = nums.size(), dn = rhs.nums.size();
+  BigInt q, r;
+
+  // dividing by a power of two is a shift of the magnitude, and the
+  // remainder is the bits shifted out
+  uint64_t top = rhs.nums[dn - 1];
+  if ((top & (top - 1)) == 0 && limbs_normalized_size(rhs.nums.data(), dn - 1) == 0) {
+    unsigned bits = __builtin_ctzll(top);
+    if (quotient) {
+      q.nums.resize(nn - dn + 1);
+      if (bits != 0) {
+        limbs_rshift(q.nums.data(), nums.data() + dn - 1, nn - dn + 1, bits);
+      } else {
+        memcpy(q.nums.data(), nums.data() + dn - 1, (nn - dn + 1) * sizeof(uint64_t));
+      }
+      q.negative = this->negative != rhs.negative;
+      q.normalize();
+      *quotient = std::move(q);
+    }
+    if (remainder) {
+      r.nums.resize(dn);
+      memcpy(r.nums.data(), nums.data(), dn * sizeof(uint64_t));
+      r.nums[dn - 1] &= top - 1;
+      r.negative = this->negative;
+      r.normalize();
+      *remainder = std::move(r);
+    }
+    return;
   }
 
-  return res;
+  q.nums.resize(quotient ? nn - dn + 1 : 0);
+  r.nums.resize(remainder ? dn : 0);
+  limbs_div_qr(quotient ? q.nums.data() : nullptr, remainder ? r.nums.data() : nullptr,
+               nums.data(), nn, rhs.nums.data(), dn);
+  q.negative = this->negative != rhs.negative;
+  r.negative = this->negative;
+
+  if (quotient) {
+    q.normalize();
+    *quotient = std::move(q);
+  }
+  if (remainder) {
+    r.normalize();
+    *remainder = std::move(r);
+  }
 }
 
 bool BigInt::is_zero() const
 {
     return nums.size() == 1 && nums[0] == 0;
 }
+
+void BigInt::normalize()
+{
+  while (nums.size() > 1 && nums.back() == 0) {
+    nums.pop_back();
+  }
+  if (nums.empty()) {
+    nums.push_back(0);
+  }
+  if (is_zero()) {
+    negative = false;
+  }
+}
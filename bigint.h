@@ -2,19 +2,24 @@
 #define BIGINT_H
 
 #include <initializer_list>
-#include <vector>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <utility>
+#include "limb_vector.h"
 
 //! @file
 //! Arbitrary-precision integer data type.
 
 //! Class representing an arbitrary-precision integer represented as a bit string
 //! (implemented using a vector of `uint64_t` elements) and a boolean flag
-//! to record whether or not the value is negative.
+//! to record whether or not the value is negative. Values of up to
+//! `LimbVector::INLINE_LIMBS` limbs are stored without a heap allocation;
+//! longer ones allocate from the memory resource that was current on
+//! the creating thread (see `LimbResourceScope`).
 class BigInt {
 private:
-  std::vector<uint64_t> nums;
+  LimbVector nums;
   bool negative;
 
 
@@ -40,12 +45,27 @@ public:
   //! @param negative if true, the value is negative
   BigInt(std::initializer_list<uint64_t> vals, bool negative = false);
 
+  //! Constructor from a view of `uint64_t` values, in the same order
+  //! as for the `std::initializer_list` constructor (e.g., the limbs of
+  //! another representation, or of `get_bit_vector()`).
+  //!
+  //! @param vals view of the values, from less-significant to
+  //!             more-significant
+  //! @param negative if true, the value is negative
+  explicit BigInt(LimbSpan vals, bool negative = false);
+
   //! Copy constructor.
   //!
   //! @param other another BigInt object that this object should be made
   //!              identical to
   BigInt(const BigInt &other);
 
+  //! Move constructor. Takes over the storage of `other`, which is
+  //! left equal to 0.
+  //!
+  //! @param other the BigInt object whose value this object takes
+  BigInt(BigInt &&other) noexcept;
+
   //! Destructor.
   ~BigInt();
 
@@ -55,22 +75,29 @@ public:
   //!            identical to
   BigInt &operator=(const BigInt &rhs);
 
+  //! Move assignment operator. Takes over the storage of `rhs`
+  //! (keeping this object's own storage if `rhs` has none on the
+  //! heap, or if `rhs` allocates from a different memory resource, in
+  //! which case the limbs are copied); `rhs` is left equal to 0.
+  //!
+  //! @param rhs the BigInt object whose value this object takes
+  BigInt &operator=(BigInt &&rhs) noexcept;
+
   //! Check whether value is negative.
   //!
   //! @return true if the value is negative, false otherwise
   bool is_negative() const;
 
-  //! Return a const reference to the underlying vector of
-  //! `uint64_t` values representing the bits of the magnitude of the
-  //! overall BigInt value. Note that the values should be in
-  //! "little endian" order: element 0 is the lowest 64 bits,
-  //! eleemnt 1 is the next-lowest 64 bits, etc. In theory,
-  //! all you should need to do is return a reference to the
-  //! internal vector the BigInt object keeps its magnitude bits in.
+  //! Return a read-only view of the `uint64_t` values representing
+  //! the bits of the magnitude of the overall BigInt value. Note that
+  //! the values are in "little endian" order: element 0 is the lowest
+  //! 64 bits, element 1 is the next-lowest 64 bits, etc. The view
+  //! supports `size()`, `data()`, indexing and iteration, and stays
+  //! valid until this object is modified or destroyed.
   //!
-  //! @return const reference to the vector containing the bit string values
+  //! @return view of the bit string values
   //!         (element at index has the least-significant 64 bits, etc.)
-  const std::vector<uint64_t> &get_bit_vector() const;
+  LimbSpan get_bit_vector() const;
 
   //! Get one `uint64_t` chunk of the overall bit string.
   //! Note that this function should work correctly regardless of the
@@ -85,14 +112,15 @@ public:
   //!         containing the bit string)
   uint64_t get_bits(unsigned index) const;
 
-  //! Addition operator.
+  //! Addition operator. The sum is computed directly into the result.
   //!
   //! @param rhs the right-hand side BigInt value (the left hand value
   //!            is the implicit receiver object, i.e., `*this`)
   //! @return the BigInt value representing the sum of the operands
   BigInt operator+(const BigInt &rhs) const;
 
-  //! Subtraction operator.
+  //! Subtraction operator. The difference is computed directly into
+  //! the result.
   //!
   //! @param rhs the right-hand side BigInt value (the left hand value
   //!            is the implicit receiver object, i.e., `*this`)
@@ -122,6 +150,61 @@ public:
   //! @throw std::invalid_argument if this object represents a negative value
   BigInt operator<<(unsigned n) const;
 
+  //! Compute `(*this + rhs) << n` in a single pass over the operands,
+  //! without materializing the sum.
+  //!
+  //! @param rhs the value to add
+  //! @param n number of bits to shift the sum left by
+  //! @return the sum shifted left by `n` bits
+  //! @throw std::invalid_argument if `n` is non-zero and the sum is
+  //!        negative
+  BigInt add_lshift(const BigInt &rhs, unsigned n) const;
+
+  //! Compute `(*this - rhs) << n` in a single pass, like `add_lshift`.
+  //!
+  //! @param rhs the value to subtract
+  //! @param n number of bits to shift the difference left by
+  //! @return the difference shifted left by `n` bits
+  //! @throw std::invalid_argument if `n` is non-zero and the difference
+  //!        is negative
+  BigInt sub_lshift(const BigInt &rhs, unsigned n) const;
+
+  //! Right shift by n bits. The result is rounded towards negative
+  //! infinity, as for `>>=`, so that it equals the floor of this value
+  //! divided by `2^n`.
+  //!
+  //! @param n number of bits to shift right by
+  //! @return BigInt value representing the result of shifting this
+  //!         value right by `n` bits
+  BigInt operator>>(unsigned n) const;
+
+  //! Bitwise AND operator. Negative values take part as their (infinitely
+  //! sign-extended) two's complement representation, so e.g.
+  //! `-1 & x == x` and `x & -x` is the lowest set bit of `x`.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return the bitwise AND of the operands
+  BigInt operator&(const BigInt &rhs) const;
+
+  //! Bitwise OR operator, on two's complement representations as for
+  //! `&`.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return the bitwise OR of the operands
+  BigInt operator|(const BigInt &rhs) const;
+
+  //! Bitwise exclusive OR operator, on two's complement representations
+  //! as for `&`.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return the bitwise exclusive OR of the operands
+  BigInt operator^(const BigInt &rhs) const;
+
+  //! Bitwise complement operator. In two's complement, `~x == -x - 1`.
+  //!
+  //! @return the bitwise complement of this value
+  BigInt operator~() const;
+
   //! Multiplication operator.
   //!
   //! @param rhs the right-hand side BigInt value (the left hand value
@@ -129,6 +212,15 @@ public:
   //! @return the BigInt value representing the product of the operands
   BigInt operator*(const BigInt &rhs) const;
 
+  //! Square this value. Squaring kernels compute each cross product of
+  //! limbs once, so this takes roughly half the limb multiplications of
+  //! a general product at schoolbook sizes (and proportionally fewer
+  //! at larger ones). `a * a`, and `a * b` when `a` and `b` have equal
+  //! magnitudes, are evaluated this way too.
+  //!
+  //! @return the square of this value
+  BigInt square() const;
+
   //! Division operator.
   //! Note that since BigInt objects represent integers, this
   //! operator should return a quotient value with the largest
@@ -151,6 +243,235 @@ public:
   //!        equal to 0
   BigInt operator/(const BigInt &rhs) const;
 
+  //! Remainder operator.
+  //! The remainder is the one left over by the truncating division
+  //! performed by `operator/`, so it has the sign of the dividend
+  //! (the left-hand object) and satisfies `(a / b) * b + a % b == a`.
+  //!
+  //! Some examples to illustrate:
+  //! - `5 % 2 = 1`
+  //! - `-5 % 2 = -1`
+  //! - `5 % -2 = 1`
+  //! - `-5 % -2 = -1`
+  //!
+  //! @param rhs the right-hand side BigInt value (the left hand value
+  //!            is the implicit receiver object, i.e., `*this`)
+  //! @return the remainder resulting from dividing the left hand
+  //!         BigInt by the right-hand BigInt
+  //! @throw std::invalid_argument if the right hand object is
+  //!        equal to 0
+  BigInt operator%(const BigInt &rhs) const;
+
+  //! Compute the quotient and the remainder of a division together,
+  //! in a single pass. The results are the same as those of
+  //! `operator/` and `operator%`.
+  //!
+  //! @param rhs the divisor (the dividend is the implicit receiver
+  //!            object, i.e., `*this`)
+  //! @return a pair whose first element is the quotient and whose
+  //!         second element is the remainder
+  //! @throw std::invalid_argument if the right hand object is
+  //!        equal to 0
+  std::pair<BigInt, BigInt> divmod(const BigInt &rhs) const;
+
+  //! Addition assignment operator. The sum is computed in place,
+  //! reusing this object's storage (growing it if needed), so
+  //! accumulating into a BigInt does not allocate a temporary.
+  //!
+  //! @param rhs the value to add
+  //! @return reference to this object, which now holds the sum
+  BigInt &operator+=(const BigInt &rhs);
+
+  //! Subtraction assignment operator. Computed in place, like `+=`.
+  //!
+  //! @param rhs the value to subtract
+  //! @return reference to this object, which now holds the difference
+  BigInt &operator-=(const BigInt &rhs);
+
+  //! Multiply-accumulate: add `a * b` to this value in place. Below
+  //! the Karatsuba threshold the product is accumulated row by row
+  //! into this object's storage, without a temporary; larger products
+  //! are added in balanced pieces (see `limbs_addmul`). `c + a * b`
+  //! is best written as a copy of `c` followed by `addmul`. Either
+  //! operand may be this object, in which case the product is formed
+  //! separately first.
+  //!
+  //! @param a the multiplicand
+  //! @param b the multiplier
+  //! @return reference to this object, which now holds the sum
+  BigInt &addmul(const BigInt &a, const BigInt &b);
+
+  //! Multiply-subtract: subtract `a * b` from this value in place, as
+  //! for `addmul`.
+  //!
+  //! @param a the multiplicand
+  //! @param b the multiplier
+  //! @return reference to this object, which now holds the difference
+  BigInt &submul(const BigInt &a, const BigInt &b);
+
+  //! Multiplication assignment operator. The product is built in this
+  //! object's storage when it has room for it; otherwise the storage
+  //! is replaced with one large enough.
+  //!
+  //! @param rhs the value to multiply by
+  //! @return reference to this object, which now holds the product
+  BigInt &operator*=(const BigInt &rhs);
+
+  //! Left shift assignment operator, shifting in place. As for
+  //! `operator<<`, only allowed on non-negative values.
+  //!
+  //! @param n number of bits to shift left by
+  //! @return reference to this object, which now holds the result
+  //! @throw std::invalid_argument if this object represents a negative value
+  BigInt &operator<<=(unsigned n);
+
+  //! Right shift assignment operator, shifting in place. The result
+  //! is rounded towards negative infinity (as for an arithmetic shift
+  //! of a two's complement value), so `-5 >> 1 == -3`.
+  //!
+  //! @param n number of bits to shift right by
+  //! @return reference to this object, which now holds the result
+  BigInt &operator>>=(unsigned n);
+
+  //! Bitwise AND assignment operator, combining the limbs in place.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return reference to this object, which now holds the result
+  BigInt &operator&=(const BigInt &rhs);
+
+  //! Bitwise OR assignment operator, combining the limbs in place.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return reference to this object, which now holds the result
+  BigInt &operator|=(const BigInt &rhs);
+
+  //! Bitwise exclusive OR assignment operator, combining the limbs in
+  //! place.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return reference to this object, which now holds the result
+  BigInt &operator^=(const BigInt &rhs);
+
+  //! Division assignment operator.
+  //!
+  //! @param rhs the divisor
+  //! @return reference to this object, which now holds the quotient
+  //! @throw std::invalid_argument if the right hand object is
+  //!        equal to 0
+  BigInt &operator/=(const BigInt &rhs);
+
+  //! Remainder assignment operator.
+  //!
+  //! @param rhs the divisor
+  //! @return reference to this object, which now holds the remainder
+  //! @throw std::invalid_argument if the right hand object is
+  //!        equal to 0
+  BigInt &operator%=(const BigInt &rhs);
+
+  //! Modular exponentiation: compute `this^exp mod mod`, using
+  //! Montgomery multiplication (for an odd modulus) and a sliding
+  //! window over the exponent bits, without ever forming the full
+  //! power. The result is in the range `[0, mod)`, also for a negative
+  //! base.
+  //!
+  //! @param exp the exponent, which must not be negative
+  //! @param mod the modulus, which must be positive
+  //! @return the value of `this^exp mod mod`
+  //! @throw std::invalid_argument if `exp` is negative or `mod` is
+  //!        not positive
+  BigInt modpow(const BigInt &exp, const BigInt &mod) const;
+
+  //! Integer power: compute `this^exp` by left-to-right binary
+  //! exponentiation, squaring for each exponent bit and multiplying
+  //! by the base for each set bit. The size of the result is known
+  //! from the exponent and the bit length of the base, so its storage
+  //! is allocated once up front. Trailing zero bits of the base are
+  //! split off and applied as a single shift at the end, so a power
+  //! of two base costs only the shift. `0^0` is 1.
+  //!
+  //! @param exp the exponent
+  //! @return the value of `this^exp`
+  //! @throw std::invalid_argument if the result would be too large to
+  //!        represent
+  BigInt pow(uint64_t exp) const;
+
+  //! Integer square root: the largest integer `r` such that
+  //! `r*r <= this`. Computed by Newton's method with precision doubling,
+  //! in time proportional to a few divisions of this value's size.
+  //!
+  //! @return the integer square root
+  //! @throw std::invalid_argument if this value is negative
+  BigInt isqrt() const;
+
+  //! Integer k-th root: the largest integer `r` such that
+  //! `r^k <= this`, for a non-negative value. For a negative value
+  //! and odd `k`, the root is rounded towards zero (that is, it is
+  //! `-iroot(-this, k)`).
+  //!
+  //! @param k the degree of the root, which must be at least 1
+  //! @return the integer k-th root
+  //! @throw std::invalid_argument if `k` is 0, or if `k` is even and
+  //!        this value is negative
+  BigInt iroot(unsigned k) const;
+
+  //! Check whether this value is the square of an integer. Most
+  //! non-squares are rejected by their residues modulo a few small
+  //! numbers without computing the square root.
+  //!
+  //! @return true if this value is a perfect square, false otherwise
+  bool is_perfect_square() const;
+
+  //! Test whether this value is a prime. After trial division by the
+  //! small primes (by one single-limb remainder per group of primes),
+  //! runs the Baillie-PSW test: a strong probable prime test to base 2
+  //! (with Montgomery `modpow`) and a strong Lucas test. No composite
+  //! is known to pass it. Values below 2^24 are decided exactly by
+  //! trial division.
+  //!
+  //! @param rounds number of additional strong probable prime tests to
+  //!        pseudo-random bases (seeded from this value, so the result
+  //!        is reproducible)
+  //! @return true if this value is (probably) prime, false if it is
+  //!         certainly not (including all values less than 2)
+  bool is_probable_prime(unsigned rounds = 0) const;
+
+  //! Find the smallest probable prime (in the sense of
+  //! `is_probable_prime()`) greater than this value. Windows of
+  //! candidates are sieved by the small primes, so that only the
+  //! survivors are tested.
+  //!
+  //! @return the next prime after this value (2 for values below 2)
+  BigInt next_prime() const;
+
+  //! Greatest common divisor, computed with Lehmer's algorithm (and
+  //! a subquadratic half-GCD recursion for large operands). The signs
+  //! of the operands are ignored.
+  //!
+  //! @param rhs the other operand
+  //! @return the (non-negative) greatest common divisor of this value
+  //!         and `rhs`; 0 if both are 0
+  BigInt gcd(const BigInt &rhs) const;
+
+  //! Extended greatest common divisor: compute `g = gcd(this, rhs)`
+  //! together with cofactors `s` and `t` such that
+  //! `s*this + t*rhs == g`. The cofactors satisfy `|s| <= |rhs|/g`
+  //! and `|t| <= |this|/g`.
+  //!
+  //! @param rhs the other operand
+  //! @param s receives the cofactor of this value
+  //! @param t receives the cofactor of `rhs`
+  //! @return the (non-negative) greatest common divisor
+  BigInt xgcd(const BigInt &rhs, BigInt &s, BigInt &t) const;
+
+  //! Modular inverse: the value `x` in `[0, mod)` such that
+  //! `this*x mod mod == 1`.
+  //!
+  //! @param mod the modulus, which must be positive
+  //! @return the inverse of this value modulo `mod`
+  //! @throw std::invalid_argument if `mod` is not positive, or if this
+  //!        value and `mod` are not coprime
+  BigInt modinv(const BigInt &mod) const;
+
   //! Compare two BigInt values, returning
   //!   - negative if lhs < rhs
   //!   - 0 if lhs < rhs
@@ -185,8 +506,110 @@ public:
   //! @return the value of this BigInt object in decimal (base-10)
   std::string to_dec() const;
 
+  //! Create a BigInt from its decimal (base-10) representation: an
+  //! optional leading minus sign followed by one or more digits.
+  //! Leading zeros are allowed. Long strings are parsed in time close
+  //! to that of one multiplication of the result's size.
+  //!
+  //! @param str the decimal string, e.g. as produced by `to_dec()`
+  //! @return the BigInt value represented by `str`
+  //! @throw std::invalid_argument if `str` is not a valid decimal string
+  static BigInt from_dec(std::string_view str);
+
+  //! Create a BigInt from its hexadecimal (base-16) representation:
+  //! an optional leading minus sign followed by one or more hexadecimal
+  //! digits, in either case. Leading zeros are allowed.
+  //!
+  //! @param str the hexadecimal string, e.g. as produced by `to_hex()`
+  //! @return the BigInt value represented by `str`
+  //! @throw std::invalid_argument if `str` is not a valid hexadecimal
+  //!        string
+  static BigInt from_hex(std::string_view str);
+
+  //! Compute the factorial `n!`. The odd part is built by the prime
+  //! swing recursion from the prime factorization of `n!`, multiplying
+  //! the prime powers with a balanced product tree, and the power of
+  //! two is applied as a shift.
+  //!
+  //! @param n the argument
+  //! @return the value of `n!`
+  //! @throw std::invalid_argument if `n` is at least 2^32 (the result
+  //!        would not fit in memory)
+  static BigInt factorial(uint64_t n);
+
+  //! Compute the binomial coefficient `n choose k`: from the prime
+  //! factorization given by Kummer's theorem, or, if `k` (or `n - k`)
+  //! is small compared to `n`, as a product tree over
+  //! `n (n-1) ... (n-k+1)` divided by `k!`.
+  //!
+  //! @param n the size of the set
+  //! @param k the size of the subsets
+  //! @return the number of `k`-element subsets of an `n`-element set
+  //!         (0 if `k > n`)
+  //! @throw std::invalid_argument if the result would not fit in
+  //!        memory
+  static BigInt binomial(uint64_t n, uint64_t k);
+
 private:
-  // TODO: add helper functions
+  //! Compare the magnitudes (absolute values) of two BigInt values.
+  //!
+  //! @param rhs the BigInt value to compare against
+  //! @return negative if |this| < |rhs|, 0 if equal, positive if greater
+  int compare_magnitudes(const BigInt &rhs) const;
+
+  //! Compute `(a + b) << n`, or `(a - b) << n` if `subtract` is set,
+  //! in a single pass over the operands.
+  //!
+  //! @throw std::invalid_argument if `n` is non-zero and the sum is
+  //!        negative
+  static BigInt shifted_sum(const BigInt &a, const BigInt &b, bool subtract, unsigned n);
+
+  //! Compute `a * b`.
+  static BigInt product(const BigInt &a, const BigInt &b);
+
+  //! Add `a * b` to this value in place, or subtract it if `subtract`
+  //! is set. Either operand may be this object.
+  void add_product_in_place(const BigInt &a, const BigInt &b, bool subtract);
+
+  //! Add `rhs`, or rather the value with the magnitude of `rhs` and
+  //! the sign given by `rhs_negative`, to this value in place.
+  //! `rhs` may be this object.
+  //!
+  //! @param rhs the addend
+  //! @param rhs_negative the sign to use for the addend
+  void add_in_place(const BigInt &rhs, bool rhs_negative);
+
+  //! Replace this value with `op(this, rhs)`, applying `op` to each
+  //! limb of the two's complement representations of the operands.
+  //! `rhs` may be this object.
+  //!
+  //! @param rhs the right-hand operand
+  //! @param op bitwise operation on two `uint64_t` limbs
+  template <typename Op>
+  void bitwise_in_place(const BigInt &rhs, Op op);
+
+  //! Divide this value by `rhs` (truncating), storing the quotient
+  //! and/or the remainder; either pointer may be null if that part
+  //! of the result is not wanted.
+  //!
+  //! @param rhs the divisor
+  //! @param quotient if not null, receives the quotient
+  //! @param remainder if not null, receives the remainder
+  //! @throw std::invalid_argument if `rhs` is equal to 0
+  void divide(const BigInt &rhs, BigInt *quotient, BigInt *remainder) const;
+
+  //! Check whether this value is 0.
+  //!
+  //! @return true if the value is 0, false otherwise
+  bool is_zero() const;
+
+  //! Restore the representation invariants after the limbs have been
+  //! modified directly: discard high zero limbs (keeping at least one)
+  //! and make sure 0 is never negative.
+  void normalize();
+
+  friend class BigIntModContext;
+  friend class BigIntGcd;
 };
 
 #endif // BIGINT_H
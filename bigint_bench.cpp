@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include "bigint.h"
+#include "bigint_limbs.h"
+
+// Benchmark driver for BigInt and its kernels.
+//
+// Usage: bigint_bench [sweep [max_limbs] [op ...] [threshold=value ...]]
+//        bigint_bench div [bz_threshold]
+//
+// The size sweep (the default) times each BigInt operation for
+// operand sizes of 1, 2, 4, ... limbs up to max_limbs (default 2^20),
+// and reports ns/op, limbs/s, heap allocations per operation, the
+// local growth exponent between successive sizes and an exponent
+// fitted over the larger sizes. Naming ops restricts the sweep to
+// them. A size is the last one timed for an op once a single call
+// takes more than a second. Arguments of the form threshold=value
+// override one of the algorithm thresholds in bigint_limbs.h (e.g.
+// mul_toom3_threshold=200), so that sweeps with different values can
+// be compared to place a crossover; a value below the smallest one the
+// algorithm supports is rejected.
+//
+// The division sweep times 2n-by-n limb divisions with schoolbook
+// long division and with recursive (Burnikel-Ziegler) division, for a
+// range of n, and reports where the recursive algorithm starts to win.
+// Passing a threshold overrides div_bz_threshold (the size below which
+// the recursion bottoms out in schoolbook division).
+
+// Number of calls to the global operator new so far; replacing the
+// allocation functions counts the limb storage (which comes from the
+// default memory resource) as well as the kernels' scratch vectors.
+size_t allocation_count;
+
+void *operator new(size_t size) {
+  ++allocation_count;
+  if (void *p = malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+  free(p);
+}
+
+// Fill a vector with n pseudo-random limbs (deterministic for a given
+// seed); the top limb is forced non-zero.
+std::vector<uint64_t> random_limbs(size_t n, uint64_t seed) {
+  uint64_t state = seed * 0x9E3779B97F4A7C15UL + 1;
+  std::vector<uint64_t> limbs(n);
+  for (size_t i = 0; i < n; ++i) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    limbs[i] = state * 0x2545F4914F6CDD1DUL;
+  }
+  limbs[n - 1] |= 1;
+  return limbs;
+}
+
+// Run fn repeatedly for at least min_seconds and return the average
+// time per call in nanoseconds.
+template <typename Fn>
+double time_per_call(Fn fn, double min_seconds = 0.2) {
+  typedef std::chrono::steady_clock clock;
+  size_t reps = 1;
+  for (;;) {
+    clock::time_point start = clock::now();
+    for (size_t i = 0; i < reps; ++i) {
+      fn();
+    }
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    if (elapsed >= min_seconds) {
+      return elapsed * 1e9 / reps;
+    }
+    reps *= elapsed < min_seconds / 16 ? 8 : 2;
+  }
+}
+
+void bench_division() {
+  printf("division, 2n / n limbs (div_bz_threshold = %zu)\n", div_bz_threshold);
+  printf("%8s %16s %16s %8s\n", "n", "schoolbook ns", "recursive ns", "ratio");
+
+  size_t crossover = 0;
+  size_t sizes[] = { 8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512,
+                     1024, 2048, 4096, 8192, 16384 };
+  for (size_t n : sizes) {
+    std::vector<uint64_t> a = random_limbs(2 * n, n);
+    std::vector<uint64_t> b = random_limbs(n, n + 1);
+    std::vector<uint64_t> q(n + 1), r(n);
+
+    double schoolbook = time_per_call([&] {
+      limbs_div_qr_schoolbook(q.data(), r.data(), a.data(), 2 * n, b.data(), n);
+    });
+    double recursive = time_per_call([&] {
+      limbs_div_qr_bz(q.data(), r.data(), a.data(), 2 * n, b.data(), n);
+    });
+
+    printf("%8zu %16.0f %16.0f %8.2f\n", n, schoolbook, recursive, schoolbook / recursive);
+    if (recursive < schoolbook && crossover == 0) {
+      crossover = n;
+    } else if (recursive >= schoolbook) {
+      crossover = 0;
+    }
+  }
+
+  if (crossover != 0) {
+    printf("recursive division is faster from n = %zu limbs\n", crossover);
+  } else {
+    printf("recursive division was not faster at the largest size\n");
+  }
+}
+
+// A BigInt with n pseudo-random limbs (the top one non-zero), built
+// from its hex representation, which takes linear time.
+BigInt random_bigint(size_t n, uint64_t seed) {
+  std::vector<uint64_t> limbs = random_limbs(n, seed);
+  std::string hex(16 * n, '0');
+  char digits[17];
+  for (size_t i = 0; i < n; ++i) {
+    snprintf(digits, sizeof digits, "%016lx", limbs[n - 1 - i]);
+    memcpy(&hex[16 * i], digits, 16);
+  }
+  return BigInt::from_hex(hex);
+}
+
+// One operation of the size sweep: setup(n) creates operands of n
+// limbs and returns the call to time.
+struct SweepOp {
+  const char *name;
+  const char *description;
+  std::function<std::function<void()>(size_t)> setup;
+};
+
+// Keeps the results of calls that return plain values observable.
+volatile int sink;
+
+std::vector<SweepOp> sweep_ops() {
+  return {
+    { "add", "r = a + b, a and b of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1), b = random_bigint(n, 2), r;
+        return [=]() mutable { r = a + b; };
+      } },
+    { "sub", "r = a - b, a and b of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1), b = random_bigint(n, 2), r;
+        return [=]() mutable { r = a - b; };
+      } },
+    { "mul", "r = a * b, a and b of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1), b = random_bigint(n, 2), r;
+        return [=]() mutable { r = a * b; };
+      } },
+    { "sqr", "r = a.square(), a of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1), r;
+        return [=]() mutable { r = a.square(); };
+      } },
+    { "div", "r = a / b, a of 2n limbs and b of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(2 * n, 1), b = random_bigint(n, 2), r;
+        return [=]() mutable { r = a / b; };
+      } },
+    { "shl", "r = a << 100, a of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1), r;
+        return [=]() mutable { r = a << 100; };
+      } },
+    { "compare", "a.compare(b), a and b of n limbs differing in the lowest bit", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1);
+        BigInt b = a ^ BigInt(1);
+        return [=] { sink = a.compare(b); };
+      } },
+    { "to_hex", "a.to_hex(), a of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1);
+        return [=] { sink = a.to_hex().size(); };
+      } },
+    { "to_dec", "a.to_dec(), a of n limbs", [](size_t n) -> std::function<void()> {
+        BigInt a = random_bigint(n, 1);
+        return [=] { sink = a.to_dec().size(); };
+      } },
+    { "from_hex", "BigInt::from_hex(s), s the hex digits of n limbs", [](size_t n) -> std::function<void()> {
+        std::string s = random_bigint(n, 1).to_hex();
+        BigInt r;
+        return [=]() mutable { r = BigInt::from_hex(s); };
+      } },
+    { "from_dec", "BigInt::from_dec(s), s the decimal digits of n limbs", [](size_t n) -> std::function<void()> {
+        std::string s = random_bigint(n, 1).to_dec();
+        BigInt r;
+        return [=]() mutable { r = BigInt::from_dec(s); };
+      } },
+  };
+}
+
+// Least-squares slope of y against x.
+double fitted_slope(const std::vector<double> &x, const std::vector<double> &y) {
+  double mx = 0, my = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    mx += x[i] / x.size();
+    my += y[i] / y.size();
+  }
+  double sxy = 0, sxx = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    sxy += (x[i] - mx) * (y[i] - my);
+    sxx += (x[i] - mx) * (x[i] - mx);
+  }
+  return sxy / sxx;
+}
+
+void bench_sweep(size_t max_limbs, const std::vector<std::string> &names) {
+  // the exponent is fitted over the largest sizes timed, where the
+  // asymptotically fastest algorithm is in use and per-call overheads
+  // no longer matter
+  const size_t fit_points = 6;
+
+  std::vector<std::string> summary;
+  for (const SweepOp &op : sweep_ops()) {
+    if (!names.empty() && std::find(names.begin(), names.end(), op.name) == names.end()) {
+      continue;
+    }
+    printf("%s: %s\n", op.name, op.description);
+    printf("%8s %14s %12s %10s %8s\n", "n", "ns/op", "limbs/s", "allocs/op", "slope");
+
+    std::vector<double> log_n, log_ns;
+    for (size_t n = 1; n <= max_limbs; n *= 2) {
+      std::function<void()> call = op.setup(n);
+      // count over a second call, so that results which reuse their
+      // storage count as they do in a loop
+      call();
+      size_t before = allocation_count;
+      call();
+      size_t allocs = allocation_count - before;
+      double ns = time_per_call(call, 0.05);
+
+      printf("%8zu %14.1f %12.3g %10zu", n, ns, n * 1e9 / ns, allocs);
+      if (!log_n.empty()) {
+        printf(" %8.2f\n", (log(ns) - log_ns.back()) / (log((double) n) - log_n.back()));
+      } else {
+        printf(" %8s\n", "-");
+      }
+      log_n.push_back(log((double) n));
+      log_ns.push_back(log(ns));
+      if (ns > 1e9) {
+        break;
+      }
+    }
+
+    char line[128];
+    if (log_n.size() >= 2) {
+      size_t first = log_n.size() > fit_points ? log_n.size() - fit_points : 0;
+      double exponent = fitted_slope(std::vector<double>(log_n.begin() + first, log_n.end()),
+                                     std::vector<double>(log_ns.begin() + first, log_ns.end()));
+      size_t from = (size_t) 1 << first, to = (size_t) 1 << (log_n.size() - 1);
+      printf("fitted exponent for n = %zu..%zu: %.2f\n\n", from, to, exponent);
+      snprintf(line, sizeof line, "%-10s %8.2f   (n = %zu..%zu)", op.name, exponent, from, to);
+    } else {
+      printf("\n");
+      snprintf(line, sizeof line, "%-10s %8s", op.name, "-");
+    }
+    summary.push_back(line);
+  }
+
+  printf("fitted exponents\n");
+  for (const std::string &line : summary) {
+    printf("%s\n", line.c_str());
+  }
+}
+
+// Algorithm thresholds that can be set from the command line, with
+// the smallest value each accepts: the Karatsuba and Toom-3 kernels
+// need at least 4 and 5 limbs (see bigint_limbs.h), and every other
+// threshold is a count of at least one limb or chunk.
+struct Threshold {
+  const char *name;
+  size_t *value;
+  size_t min;
+};
+
+const Threshold thresholds[] = {
+  { "mul_karatsuba_threshold", &mul_karatsuba_threshold, 4 },
+  { "mul_toom3_threshold", &mul_toom3_threshold, 5 },
+  { "sqr_karatsuba_threshold", &sqr_karatsuba_threshold, 4 },
+  { "sqr_toom3_threshold", &sqr_toom3_threshold, 5 },
+  { "mul_ntt_threshold", &mul_ntt_threshold, 1 },
+  { "div_bz_threshold", &div_bz_threshold, 1 },
+  { "gcd_dc_threshold", &gcd_dc_threshold, 1 },
+  { "gcd_hgcd_threshold", &gcd_hgcd_threshold, 1 },
+  { "to_dec_dc_threshold", &to_dec_dc_threshold, 1 },
+  { "from_dec_dc_threshold", &from_dec_dc_threshold, 1 },
+  { "mod_barrett_threshold", &mod_barrett_threshold, 1 },
+};
+
+// Parse a decimal size; return false unless the whole string is one.
+// (strtoul alone would accept leading whitespace and a minus sign,
+// and ignore trailing garbage.)
+bool parse_size(const char *str, size_t *val) {
+  if (!isdigit((unsigned char) str[0])) {
+    return false;
+  }
+  char *end;
+  errno = 0;
+  unsigned long long parsed = strtoull(str, &end, 10);
+  if (*end != '\0' || errno == ERANGE || parsed > SIZE_MAX) {
+    return false;
+  }
+  *val = parsed;
+  return true;
+}
+
+// Set a threshold from a name=value argument, checking the value
+// against the threshold's minimum; on error, print a message and
+// return false.
+bool set_threshold(const char *arg) {
+  const char *eq = strchr(arg, '=');
+  if (eq == nullptr) {
+    fprintf(stderr, "expected threshold=value: %s\n", arg);
+    return false;
+  }
+  for (const Threshold &t : thresholds) {
+    if (strlen(t.name) == (size_t) (eq - arg) && strncmp(t.name, arg, eq - arg) == 0) {
+      size_t val;
+      if (!parse_size(eq + 1, &val)) {
+        fprintf(stderr, "invalid value for %s: %s\n", t.name, eq + 1);
+        return false;
+      }
+      if (val < t.min) {
+        fprintf(stderr, "%s must be at least %zu\n", t.name, t.min);
+        return false;
+      }
+      *t.value = val;
+      return true;
+    }
+  }
+  fprintf(stderr, "unknown threshold: %s\n", arg);
+  return false;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "div") == 0) {
+    if (argc > 2 && !set_threshold(("div_bz_threshold=" + std::string(argv[2])).c_str())) {
+      return 1;
+    }
+    bench_division();
+    return 0;
+  }
+
+  size_t max_limbs = (size_t) 1 << 20;
+  std::vector<std::string> names;
+  std::vector<SweepOp> ops = sweep_ops();
+  for (int i = argc > 1 && strcmp(argv[1], "sweep") == 0 ? 2 : 1; i < argc; ++i) {
+    if (isdigit((unsigned char) argv[i][0])) {
+      if (!parse_size(argv[i], &max_limbs) || max_limbs == 0) {
+        fprintf(stderr, "invalid size: %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strchr(argv[i], '=')) {
+      if (!set_threshold(argv[i])) {
+        return 1;
+      }
+    } else if (std::find_if(ops.begin(), ops.end(),
+                            [&](const SweepOp &op) { return strcmp(op.name, argv[i]) == 0; }) != ops.end()) {
+      names.push_back(argv[i]);
+    } else {
+      fprintf(stderr, "unknown operation: %s\n", argv[i]);
+      return 1;
+    }
+  }
+  bench_sweep(max_limbs, names);
+  return 0;
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "bigint.h"
+
+//! @file
+//! Factorials and binomial coefficients of BigInt values, built from
+//! their prime factorizations with balanced product trees.
+
+// The odd primes up to n, from a sieve over the odd numbers.
+static std::vector<uint64_t> odd_primes(uint64_t n)
+{
+  std::vector<uint64_t> primes;
+  if (n < 3) {
+    return primes;
+  }
+  std::vector<bool> composite((n - 1) / 2); // index i stands for 2i + 3
+  for (uint64_t i = 0; i < composite.size(); ++i) {
+    if (composite[i]) {
+      continue;
+    }
+    uint64_t p = 2 * i + 3;
+    primes.push_back(p);
+    for (uint64_t j = (p * p - 3) / 2; j < composite.size(); j += p) {
+      composite[j] = true;
+    }
+  }
+  return primes;
+}
+
+// Append a factor to a list of limbs, multiplying it into the last one
+// if the product still fits, so that each limb is about 64 bits.
+static void push_factor(std::vector<uint64_t> &limbs, uint64_t f)
+{
+  if (!limbs.empty() && limbs.back() <= UINT64_MAX / f) {
+    limbs.back() *= f;
+  } else {
+    limbs.push_back(f);
+  }
+}
+
+// Product of f[lo..hi), hi > lo. Splitting the range in halves keeps
+// the operands of each multiplication about the same size, so the
+// large ones are balanced and use the fast multiplication tiers.
+static BigInt product_tree(const std::vector<uint64_t> &f, size_t lo, size_t hi)
+{
+  if (hi - lo <= 4) {
+    BigInt res(f[lo]);
+    for (size_t i = lo + 1; i < hi; ++i) {
+      res *= BigInt(f[i]);
+    }
+    return res;
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  BigInt res = product_tree(f, lo, mid);
+  res *= product_tree(f, mid, hi);
+  return res;
+}
+
+static BigInt product_of(const std::vector<uint64_t> &f)
+{
+  return f.empty() ? BigInt(1) : product_tree(f, 0, f.size());
+}
+
+// The odd part of n!, by Luschny's prime swing recursion: the odd part
+// of n! is that of (n/2)!, squared, times that of the swing
+// n! / ((n/2)!)^2, in which each odd prime p has the exponent
+// sum_i (floor(n / p^i) mod 2), so that its prime power is at most n.
+static BigInt odd_factorial(uint64_t n, const std::vector<uint64_t> &primes)
+{
+  if (n <= 20) {
+    uint64_t f = 1;
+    for (uint64_t i = 2; i <= n; ++i) {
+      f *= i;
+    }
+    return BigInt(f >> __builtin_ctzll(f));
+  }
+
+  std::vector<uint64_t> swing;
+  for (uint64_t p : primes) {
+    if (p > n) {
+      break;
+    }
+    uint64_t pe = 1;
+    for (uint64_t q = n / p; q > 0; q /= p) {
+      if (q & 1) {
+        pe *= p;
+      }
+    }
+    if (pe > 1) {
+      push_factor(swing, pe);
+    }
+  }
+
+  BigInt res = odd_factorial(n / 2, primes).square();
+  res *= product_of(swing);
+  return res;
+}
+
+BigInt BigInt::factorial(uint64_t n)
+{
+  if (n > UINT32_MAX) {
+    throw std::invalid_argument("factorial too large");
+  }
+  // n! = (odd part) * 2^(n - popcount(n))
+  BigInt res = odd_factorial(n, odd_primes(n));
+  res <<= (unsigned) (n - __builtin_popcountll(n));
+  return res;
+}
+
+BigInt BigInt::binomial(uint64_t n, uint64_t k)
+{
+  if (k > n) {
+    return BigInt();
+  }
+  k = std::min(k, n - k);
+  if (k == 0) {
+    return BigInt(1);
+  }
+
+  if (n / k > 48) {
+    // Few factors compared to n: sieving up to n would cost more than
+    // n (n-1) ... (n-k+1) / k!, with a product tree for the numerator
+    // (timed at n = 10^4 and 10^6, the two cross at n/k of 40-60).
+    std::vector<uint64_t> numerator;
+    for (uint64_t i = n - k + 1; i <= n && i != 0; ++i) {
+      push_factor(numerator, i);
+    }
+    return product_of(numerator) / factorial(k);
+  }
+
+  if (n > UINT32_MAX) {
+    throw std::invalid_argument("binomial coefficient too large");
+  }
+
+  // By Kummer's theorem, the exponent of p is the number of borrows
+  // when subtracting k from n in base p, which makes each prime power
+  // at most n. For p = 2 that is popcount(k) + popcount(n-k) - popcount(n).
+  std::vector<uint64_t> factors;
+  for (uint64_t p : odd_primes(n)) {
+    uint64_t pe = 1;
+    for (uint64_t a = n / p, b = k / p, c = (n - k) / p; a > 0; a /= p, b /= p, c /= p) {
+      if (a - b - c != 0) {
+        pe *= p;
+      }
+    }
+    if (pe > 1) {
+      push_factor(factors, pe);
+    }
+  }
+  BigInt res = product_of(factors);
+  res <<= (unsigned) (__builtin_popcountll(k) + __builtin_popcountll(n - k) - __builtin_popcountll(n));
+  return res;
+}
@@ -0,0 +1,489 @@
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include "bigint.h"
+#include "bigint_limbs.h"
+
+//! @file
+//! Greatest common divisors of BigInt values: Lehmer's algorithm on
+//! double-limb leading digits, a half-GCD recursion for large
+//! operands, and the extended GCD and modular inverse built on them.
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+// Both timed on random operands of equal length. Within the half-GCD,
+// recursing pays off for reductions of more than ~100-150 limbs; but
+// since it also has to track the cofactors, which Lehmer's algorithm
+// for a plain gcd does not, the top level only gains from it for
+// operands of a few thousand limbs (the multiplications it relies on
+// being Toom-3 at that size).
+size_t gcd_hgcd_threshold = 120;
+size_t gcd_dc_threshold = 2500;
+
+// Euclid's algorithm is carried out as a sequence of steps on a pair
+// (a, b) with a >= b >= 0, each replacing it by (b, a mod b) (a few
+// steps swap a and b instead). Every step is an integer matrix of
+// determinant +1 or -1, so the gcd is preserved; the product of the
+// inverses of the steps taken is recorded in a matrix M with
+// non-negative entries such that (a0; b0) = M (a; b), where (a0, b0)
+// is the original pair. M is what the half-GCD recursion uses to
+// apply a reduction computed on the leading limbs to the full values,
+// and what the extended GCD reads the cofactors from.
+class BigIntGcd {
+public:
+  struct Matrix {
+    BigInt m[2][2];
+    int det;
+    bool changed;
+
+    Matrix() : m{ { BigInt(1), BigInt() }, { BigInt(), BigInt(1) } }, det(1), changed(false) { }
+  };
+
+  static BigInt small(int128_t u);
+  static bool below(const BigInt &x, size_t s);
+  static BigInt high_part(const BigInt &x, size_t p);
+  static void order(BigInt &a, BigInt &b, Matrix *M);
+  static void apply_quotient(Matrix *M, const BigInt &q);
+  static void apply_cofactors(Matrix *M, int128_t A, int128_t B, int128_t C, int128_t D, int e);
+  static void compose(Matrix *M, const Matrix &M1);
+  static bool div_step(BigInt &a, BigInt &b, size_t s, Matrix *M);
+  static bool lehmer_step(BigInt &a, BigInt &b, Matrix *M, LimbVector &t1, LimbVector &t2);
+  static void small_finish(BigInt &a, BigInt &b, Matrix *M);
+  static void base(BigInt &a, BigInt &b, size_t s, Matrix *M);
+  static void reduce(BigInt &a, BigInt &b, size_t s, Matrix *M);
+  static void run(BigInt &a, BigInt &b, Matrix *M);
+};
+
+// A BigInt with the (signed) value u.
+BigInt BigIntGcd::small(int128_t u)
+{
+  uint128_t mag = u < 0 ? -(uint128_t) u : (uint128_t) u;
+  BigInt r({ (uint64_t) mag, (uint64_t) (mag >> 64) }, u < 0);
+  r.normalize();
+  return r;
+}
+
+// Return true if x < 2^(64s) (for s == 0, if x == 0).
+bool BigIntGcd::below(const BigInt &x, size_t s)
+{
+  return s == 0 ? x.is_zero() : x.nums.size() <= s;
+}
+
+// floor(x / 2^(64p))
+BigInt BigIntGcd::high_part(const BigInt &x, size_t p)
+{
+  BigInt r;
+  if (x.nums.size() > p) {
+    r.nums.resize(x.nums.size() - p);
+    memcpy(r.nums.data(), x.nums.data() + p, (x.nums.size() - p) * sizeof(uint64_t));
+  }
+  r.normalize();
+  return r;
+}
+
+// Make sure that a >= b, swapping them if necessary.
+void BigIntGcd::order(BigInt &a, BigInt &b, Matrix *M)
+{
+  if (a.compare_magnitudes(b) >= 0) {
+    return;
+  }
+  std::swap(a, b);
+  if (M) {
+    std::swap(M->m[0][0], M->m[0][1]);
+    std::swap(M->m[1][0], M->m[1][1]);
+    M->det = -M->det;
+    M->changed = true;
+  }
+}
+
+// Record the step (a, b) -> (b, a - q*b).
+void BigIntGcd::apply_quotient(Matrix *M, const BigInt &q)
+{
+  for (int i = 0; i < 2; ++i) {
+    // (m0, m1) -> (m0*q + m1, m0), accumulating into m1's storage
+    M->m[i][1].addmul(M->m[i][0], q);
+    std::swap(M->m[i][0], M->m[i][1]);
+  }
+  M->det = -M->det;
+  M->changed = true;
+}
+
+// rp[0..n] = u*ap[0..n) + v*bp[0..n), which the caller knows to be
+// non-negative, for cofactors u and v of opposite signs (or zero).
+static void combine(uint64_t *rp, int64_t u, const uint64_t *ap, int64_t v, const uint64_t *bp, size_t n)
+{
+  if (v <= 0) {
+    rp[n] = limbs_mul_1(rp, ap, n, u);
+    rp[n] -= limbs_submul_1(rp, bp, n, -(uint64_t) v);
+  } else {
+    rp[n] = limbs_mul_1(rp, bp, n, v);
+    rp[n] -= limbs_submul_1(rp, ap, n, -(uint64_t) u);
+  }
+}
+
+// rp[0..n] = u*ap[0..n) + v*bp[0..n)
+static void combine_add(uint64_t *rp, uint64_t u, const uint64_t *ap, uint64_t v, const uint64_t *bp, size_t n)
+{
+  rp[n] = limbs_mul_1(rp, ap, n, u);
+  rp[n] += limbs_addmul_1(rp, bp, n, v);
+}
+
+// Record the steps (a, b) -> (A*a + B*b, C*a + D*b), whose matrix has
+// determinant e = AD - BC = +-1: (-1)^k after k steps. The caller
+// passes e in, since the products can overflow 128 bits.
+void BigIntGcd::apply_cofactors(Matrix *M, int128_t A, int128_t B, int128_t C, int128_t D, int e)
+{
+  // multiply M by the inverse e [[D, -B], [-C, A]], whose entries are
+  // all non-negative
+  const int128_t min64 = INT64_MIN, max64 = INT64_MAX;
+  bool fits = A >= min64 && A <= max64 && B >= min64 && B <= max64 &&
+              C >= min64 && C <= max64 && D >= min64 && D <= max64;
+  for (int i = 0; i < 2; ++i) {
+    BigInt &x = M->m[i][0], &y = M->m[i][1];
+    BigInt c0, c1;
+    if (fits) {
+      // the usual case (a Lehmer batch): a pass over the limbs for each
+      // new entry
+      size_t n = x.nums.size() > y.nums.size() ? x.nums.size() : y.nums.size();
+      x.nums.resize(n);
+      y.nums.resize(n);
+      c0.nums.resize(n + 1);
+      c1.nums.resize(n + 1);
+      combine_add(c0.nums.data(), (uint64_t) (e * D), x.nums.data(), (uint64_t) (-e * C), y.nums.data(), n);
+      combine_add(c1.nums.data(), (uint64_t) (-e * B), x.nums.data(), (uint64_t) (e * A), y.nums.data(), n);
+      c0.normalize();
+      c1.normalize();
+    } else {
+      c0.addmul(small(e * D), x).addmul(small(-e * C), y);
+      c1.addmul(small(-e * B), x).addmul(small(e * A), y);
+    }
+    x = std::move(c0);
+    y = std::move(c1);
+  }
+  M->det *= e;
+  M->changed = true;
+}
+
+// M = M * M1
+void BigIntGcd::compose(Matrix *M, const Matrix &M1)
+{
+  for (int i = 0; i < 2; ++i) {
+    BigInt c0, c1;
+    c0.addmul(M->m[i][0], M1.m[0][0]).addmul(M->m[i][1], M1.m[1][0]);
+    c1.addmul(M->m[i][0], M1.m[0][1]).addmul(M->m[i][1], M1.m[1][1]);
+    M->m[i][0] = std::move(c0);
+    M->m[i][1] = std::move(c1);
+  }
+  M->det *= M1.det;
+  M->changed = true;
+}
+
+// One Euclidean step by division, for a >= b > 0, unless the remainder
+// would be less than 2^(64s) (for s == 0: unless it would be 0).
+bool BigIntGcd::div_step(BigInt &a, BigInt &b, size_t s, Matrix *M)
+{
+  BigInt q, r;
+  a.divide(b, M ? &q : nullptr, &r);
+  if (below(r, s)) {
+    return false;
+  }
+  if (M) {
+    apply_quotient(M, q);
+  }
+  a = std::move(b);
+  b = std::move(r);
+  return true;
+}
+
+// floor(n / d) for n >= 0 and d > 0. Most quotients in Euclid's
+// algorithm are small, and subtracting is much cheaper than a 128-bit
+// division.
+template <typename T>
+static inline T quotient(T n, T d)
+{
+  T q = 0;
+  for (int i = 0; i < 4 && n >= d; ++i) {
+    n -= d;
+    ++q;
+  }
+  return n >= d ? q + n / d : q;
+}
+
+// Bits [h, h+128) of the magnitude of x.
+static uint128_t bits_at(const LimbVector &x, size_t h)
+{
+  size_t i = h / 64, n = x.size();
+  unsigned shift = h % 64;
+  uint64_t l0 = i < n ? x[i] : 0, l1 = i + 1 < n ? x[i + 1] : 0, l2 = i + 2 < n ? x[i + 2] : 0;
+  uint128_t v = ((uint128_t) l1 << 64) | l0;
+  if (shift != 0) {
+    v = (v >> shift) | ((uint128_t) l2 << (128 - shift));
+  }
+  return v;
+}
+
+// A batch of Euclidean steps computed from the leading 126 bits of a
+// and the corresponding bits of b, for a >= b with b at least two limbs
+// longer than the limit it must stay above. Returns false (leaving a and
+// b alone) if not even one step could be determined that way.
+bool BigIntGcd::lehmer_step(BigInt &a, BigInt &b, Matrix *M, LimbVector &t1, LimbVector &t2)
+{
+  size_t n = a.nums.size();
+  size_t bits = 64 * n - __builtin_clzll(a.nums.back());
+  size_t h = bits > 126 ? bits - 126 : 0;
+  int128_t x = bits_at(a.nums, h), y = bits_at(b.nums, h);
+
+  // Knuth, TAOCP vol. 2, 4.5.2, Algorithm L, with double-limb digits: a
+  // quotient is accepted only if both bracketing estimates agree. The
+  // remainders are kept at 2^64 or more, which bounds the cofactors by
+  // 2^62 and keeps the true remainders within a limb of a's length.
+  const int128_t limit = (int128_t) 1 << 64;
+  int128_t A = 1, B = 0, C = 0, D = 1;
+  int det = 1;
+  while (y >= limit) {
+    int128_t yc = y + C, yd = y + D;
+    if (yc <= 0 || yd <= 0 || x + A < 0 || x + B < 0) {
+      break;
+    }
+    int128_t q = quotient(x + A, yc), xb = x + B, low = q * yd;
+    if (q == 0 || xb < low || xb - low >= yd) {
+      break;
+    }
+    int128_t r = x - q * y;
+    if (r < limit) {
+      break;
+    }
+    int128_t t = A - q * C;
+    A = C;
+    C = t;
+    t = B - q * D;
+    B = D;
+    D = t;
+    det = -det;
+    x = y;
+    y = r;
+  }
+  if (B == 0) {
+    return false;
+  }
+
+  b.nums.resize(n);
+  t1.resize(n + 1);
+  t2.resize(n + 1);
+  combine(t1.data(), (int64_t) A, a.nums.data(), (int64_t) B, b.nums.data(), n);
+  combine(t2.data(), (int64_t) C, a.nums.data(), (int64_t) D, b.nums.data(), n);
+  std::swap(a.nums, t1);
+  std::swap(b.nums, t2);
+  a.normalize();
+  b.normalize();
+  if (M) {
+    apply_cofactors(M, A, B, C, D, det);
+  }
+  return true;
+}
+
+// Finish Euclid's algorithm for a >= b > 0 and a < 2^127 in 128-bit
+// arithmetic, stopping when the next remainder would be 0.
+void BigIntGcd::small_finish(BigInt &a, BigInt &b, Matrix *M)
+{
+  uint128_t x = ((uint128_t) (a.nums.size() > 1 ? a.nums[1] : 0) << 64) | a.nums[0];
+  uint128_t y = ((uint128_t) (b.nums.size() > 1 ? b.nums[1] : 0) << 64) | b.nums[0];
+  int128_t A = 1, B = 0, C = 0, D = 1;
+  int det = 1;
+  while (true) {
+    uint128_t q = quotient(x, y), r = x - q * y;
+    if (r == 0) {
+      break;
+    }
+    if (M) {
+      int128_t t = A - (int128_t) q * C;
+      A = C;
+      C = t;
+      t = B - (int128_t) q * D;
+      B = D;
+      D = t;
+      det = -det;
+    }
+    x = y;
+    y = r;
+  }
+  a = small(x);
+  b = small(y);
+  if (M && B != 0) {
+    apply_cofactors(M, A, B, C, D, det);
+  }
+}
+
+// Euclidean steps, while both a and b stay at least 2^(64s) (for
+// s == 0, until the next remainder would be 0), by Lehmer batches
+// while b is well above that limit and by division near it.
+void BigIntGcd::base(BigInt &a, BigInt &b, size_t s, Matrix *M)
+{
+  LimbVector t1, t2;
+  while (true) {
+    order(a, b, M);
+    if (below(b, s)) {
+      return;
+    }
+    if (s == 0 && (a.nums.size() == 1 || (a.nums.size() == 2 && a.nums[1] >> 63 == 0))) {
+      small_finish(a, b, M);
+      return;
+    }
+    if (b.nums.size() >= s + 2 && lehmer_step(a, b, M, t1, t2)) {
+      continue;
+    }
+    if (!div_step(a, b, s, M)) {
+      return;
+    }
+  }
+}
+
+// Euclidean steps while both a and b stay at least 2^(64s), as for
+// base(), but subquadratic for large reductions: each round computes
+// the matrix of about half the remaining reduction recursively from
+// the leading limbs only, and applies it to the full values.
+//
+// If (a1, b1) are the values after removing the low p limbs of a and b,
+// and M reduces (a1, b1) to a pair no smaller than 2^(64 t), then the
+// entries of M are at most 2^(64 (size - t)), so applying the inverse of
+// M to (a, b) changes the contribution of the discarded limbs by less
+// than 2^(64 (p + size - t)). Choosing p so that t exceeds half the
+// size of (a1, b1) by a limb keeps that below the reduced values, so the
+// steps are valid for (a, b) too (Moller, "On Schonhage's algorithm and
+// subquadratic integer gcd computation", 2008).
+void BigIntGcd::reduce(BigInt &a, BigInt &b, size_t s, Matrix *M)
+{
+  while (true) {
+    order(a, b, M);
+    if (below(b, s)) {
+      return;
+    }
+    size_t n = a.nums.size();
+    if (n < s + gcd_hgcd_threshold) {
+      break;
+    }
+
+    // reduce to about s + d/2 limbs using the leading n - p limbs
+    size_t d = n - s;
+    size_t target = s + (d + 1) / 2;
+    if (2 * target < n + 3) {
+      break;
+    }
+    size_t p = 2 * target - n - 2;
+    BigInt a1 = high_part(a, p), b1 = high_part(b, p);
+    Matrix M1;
+    reduce(a1, b1, target - p, &M1);
+
+    bool progress = false;
+    if (M1.changed) {
+      BigInt na, nb;
+      na.addmul(M1.m[1][1], a).submul(M1.m[0][1], b);
+      nb.addmul(M1.m[0][0], b).submul(M1.m[1][0], a);
+      if (M1.det < 0) {
+        na = -na;
+        nb = -nb;
+      }
+      if (!na.is_negative() && !nb.is_negative()) {
+        a = std::move(na);
+        b = std::move(nb);
+        if (M) {
+          compose(M, M1);
+        }
+        progress = true;
+      }
+    }
+    // if the leading limbs gave nothing (b is much shorter than a),
+    // take a step by division
+    if (!progress && !div_step(a, b, s, M)) {
+      return;
+    }
+  }
+  base(a, b, s, M);
+}
+
+// Run Euclid's algorithm on (a, b), leaving (gcd, 0).
+void BigIntGcd::run(BigInt &a, BigInt &b, Matrix *M)
+{
+  while (true) {
+    order(a, b, M);
+    if (b.is_zero()) {
+      return;
+    }
+    size_t n = a.nums.size();
+    if (n < gcd_dc_threshold) {
+      base(a, b, 0, M);
+      break;
+    }
+    reduce(a, b, n / 2 + 1, M);
+    order(a, b, M);
+    if (!div_step(a, b, 0, M)) {
+      break;
+    }
+  }
+
+  // b now divides a: take the last step
+  if (!b.is_zero()) {
+    if (M) {
+      apply_quotient(M, a / b);
+    }
+    a = std::move(b);
+    b = BigInt();
+  }
+}
+
+BigInt BigInt::gcd(const BigInt &rhs) const
+{
+  BigInt a = *this, b = rhs;
+  a.negative = false;
+  b.negative = false;
+  BigIntGcd::run(a, b, nullptr);
+  return a;
+}
+
+BigInt BigInt::xgcd(const BigInt &rhs, BigInt &s, BigInt &t) const
+{
+  BigInt a = *this, b = rhs;
+  a.negative = false;
+  b.negative = false;
+  BigIntGcd::Matrix M;
+  BigIntGcd::run(a, b, &M);
+
+  // (|this|; |rhs|) = M (g; 0), so (g; 0) = det [[m11, -m01], [-m10, m00]] (|this|; |rhs|)
+  BigInt u = std::move(M.m[1][1]), v = std::move(M.m[0][1]);
+  bool u_negative = M.det < 0, v_negative = M.det > 0;
+  if (negative) {
+    u_negative = !u_negative;
+  }
+  if (rhs.negative) {
+    v_negative = !v_negative;
+  }
+  u.negative = u_negative;
+  v.negative = v_negative;
+  u.normalize();
+  v.normalize();
+  s = std::move(u);
+  t = std::move(v);
+  return a;
+}
+
+BigInt BigInt::modinv(const BigInt &mod) const
+{
+  if (mod.negative || mod.is_zero()) {
+    throw std::invalid_argument("modulus must be positive");
+  }
+  BigInt r = *this % mod;
+  if (r.negative) {
+    r += mod;
+  }
+  BigInt s, t;
+  BigInt g = r.xgcd(mod, s, t);
+  if (g != BigInt(1)) {
+    throw std::invalid_argument("value is not invertible modulo the modulus");
+  }
+  s %= mod;
+  if (s.negative) {
+    s += mod;
+  }
+  return s;
+}
@@ -0,0 +1,944 @@
+#include <vector>
+#include "bigint_limbs.h"
+
+#if defined(__x86_64__) && defined(__ELF__) && defined(__GNUC__)
+#include <cpuid.h>
+#define LIMBS_X86_64_ASM 1
+
+// implemented in bigint_limbs_x86_64.S
+extern "C" {
+uint64_t limbs_add_n_x86_64(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n);
+uint64_t limbs_sub_n_x86_64(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n);
+uint64_t limbs_mul_1_adx(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+uint64_t limbs_addmul_1_adx(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+uint64_t limbs_submul_1_adx(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+}
+#endif
+
+typedef unsigned __int128 uint128_t;
+
+// Chosen by timing limbs_mul_basecase against limbs_mul_karatsuba on
+// balanced random operands (-O2, x86-64); the two cross at ~28-32 limbs.
+size_t mul_karatsuba_threshold = 32;
+
+// Chosen the same way, timing limbs_mul_n with and without the Toom-3
+// tier; gains start around 150 limbs and reach ~40% by 4000 limbs.
+size_t mul_toom3_threshold = 150;
+
+// Squaring thresholds, timed the same way with limbs_sqr_n. The
+// schoolbook square does about half the multiplications of a product,
+// so each tier holds on longer: Karatsuba wins from ~60 limbs and
+// Toom-3 from ~400 (the latter crossover is flat and noisy).
+size_t sqr_karatsuba_threshold = 64;
+size_t sqr_toom3_threshold = 400;
+
+// Timed with the bigint_bench division sweep: recursive division
+// overtakes schoolbook at around 60 limbs with the thresholds above.
+size_t div_bz_threshold = 60;
+
+bool limbs_asm_supported()
+{
+#ifdef LIMBS_X86_64_ASM
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (ebx & bit_BMI2) && (ebx & bit_ADX);
+#else
+  return false;
+#endif
+}
+
+// Until this is initialized (it's zero-initialized before any dynamic
+// initialization runs), the portable kernels are used.
+bool limbs_asm_enabled = limbs_asm_supported();
+
+int limbs_cmp(const uint64_t *ap, const uint64_t *bp, size_t n)
+{
+  for (size_t i = n; i > 0; --i) {
+    if (ap[i - 1] != bp[i - 1]) {
+      return ap[i - 1] < bp[i - 1] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+size_t limbs_normalized_size(const uint64_t *ap, size_t n)
+{
+  while (n > 0 && ap[n - 1] == 0) {
+    --n;
+  }
+  return n;
+}
+
+uint64_t limbs_add_n(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n)
+{
+#ifdef LIMBS_X86_64_ASM
+  if (limbs_asm_enabled) {
+    return limbs_add_n_x86_64(rp, ap, bp, n);
+  }
+#endif
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint128_t sum = (uint128_t) ap[i] + bp[i] + carry;
+    rp[i] = (uint64_t) sum;
+    carry = (uint64_t) (sum >> 64);
+  }
+  return carry;
+}
+
+uint64_t limbs_add(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  uint64_t carry = limbs_add_n(rp, ap, bp, bn);
+  return limbs_add_1(rp + bn, ap + bn, an - bn, carry);
+}
+
+uint64_t limbs_add_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b)
+{
+  size_t i = 0;
+  for (; i < n && b != 0; ++i) {
+    rp[i] = ap[i] + b;
+    b = rp[i] < b;
+  }
+  if (rp != ap) {
+    for (; i < n; ++i) {
+      rp[i] = ap[i];
+    }
+  }
+  return b;
+}
+
+uint64_t limbs_sub_n(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n)
+{
+#ifdef LIMBS_X86_64_ASM
+  if (limbs_asm_enabled) {
+    return limbs_sub_n_x86_64(rp, ap, bp, n);
+  }
+#endif
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t a = ap[i];
+    uint64_t b = bp[i];
+    uint64_t diff = a - b - borrow;
+    borrow = (a < b) || (a - b < borrow);
+    rp[i] = diff;
+  }
+  return borrow;
+}
+
+uint64_t limbs_sub(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  uint64_t borrow = limbs_sub_n(rp, ap, bp, bn);
+  return limbs_sub_1(rp + bn, ap + bn, an - bn, borrow);
+}
+
+uint64_t limbs_sub_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b)
+{
+  size_t i = 0;
+  for (; i < n && b != 0; ++i) {
+    uint64_t a = ap[i];
+    rp[i] = a - b;
+    b = a < b;
+  }
+  if (rp != ap) {
+    for (; i < n; ++i) {
+      rp[i] = ap[i];
+    }
+  }
+  return b;
+}
+
+uint64_t limbs_mul_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b)
+{
+#ifdef LIMBS_X86_64_ASM
+  if (limbs_asm_enabled) {
+    return limbs_mul_1_adx(rp, ap, n, b);
+  }
+#endif
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint128_t prod = (uint128_t) ap[i] * b + carry;
+    rp[i] = (uint64_t) prod;
+    carry = (uint64_t) (prod >> 64);
+  }
+  return carry;
+}
+
+uint64_t limbs_addmul_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b)
+{
+#ifdef LIMBS_X86_64_ASM
+  if (limbs_asm_enabled) {
+    return limbs_addmul_1_adx(rp, ap, n, b);
+  }
+#endif
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint128_t prod = (uint128_t) ap[i] * b + rp[i] + carry;
+    rp[i] = (uint64_t) prod;
+    carry = (uint64_t) (prod >> 64);
+  }
+  return carry;
+}
+
+uint64_t limbs_submul_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b)
+{
+#ifdef LIMBS_X86_64_ASM
+  if (limbs_asm_enabled) {
+    return limbs_submul_1_adx(rp, ap, n, b);
+  }
+#endif
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint128_t prod = (uint128_t) ap[i] * b + borrow;
+    uint64_t lo = (uint64_t) prod;
+    uint64_t r = rp[i];
+    rp[i] = r - lo;
+    borrow = (uint64_t) (prod >> 64) + (r < lo);
+  }
+  return borrow;
+}
+
+uint64_t limbs_lshift(uint64_t *rp, const uint64_t *ap, size_t n, unsigned cnt)
+{
+  uint64_t out = ap[n - 1] >> (64 - cnt);
+  for (size_t i = n - 1; i > 0; --i) {
+    rp[i] = (ap[i] << cnt) | (ap[i - 1] >> (64 - cnt));
+  }
+  rp[0] = ap[0] << cnt;
+  return out;
+}
+
+uint64_t limbs_rshift(uint64_t *rp, const uint64_t *ap, size_t n, unsigned cnt)
+{
+  uint64_t out = ap[0] << (64 - cnt);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    rp[i] = (ap[i] >> cnt) | (ap[i + 1] << (64 - cnt));
+  }
+  rp[n - 1] = ap[n - 1] >> cnt;
+  return out;
+}
+
+uint64_t limbs_add_lshift(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn, unsigned cnt)
+{
+  if (cnt == 0) {
+    return limbs_add(rp, ap, an, bp, bn);
+  }
+  uint64_t carry = 0, prev = 0;
+  for (size_t i = 0; i < an; ++i) {
+    uint128_t sum = (uint128_t) ap[i] + (i < bn ? bp[i] : 0) + carry;
+    uint64_t limb = (uint64_t) sum;
+    carry = (uint64_t) (sum >> 64);
+    rp[i] = (limb << cnt) | (prev >> (64 - cnt));
+    prev = limb;
+  }
+  return (carry << cnt) | (prev >> (64 - cnt));
+}
+
+uint64_t limbs_sub_lshift(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn, unsigned cnt)
+{
+  if (cnt == 0) {
+    limbs_sub(rp, ap, an, bp, bn);
+    return 0;
+  }
+  uint64_t borrow = 0, prev = 0;
+  for (size_t i = 0; i < an; ++i) {
+    uint64_t a = ap[i];
+    uint64_t b = i < bn ? bp[i] : 0;
+    uint64_t limb = a - b - borrow;
+    borrow = (a < b) || (a - b < borrow);
+    rp[i] = (limb << cnt) | (prev >> (64 - cnt));
+    prev = limb;
+  }
+  return prev >> (64 - cnt);
+}
+
+void limbs_mul_basecase(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  rp[an] = limbs_mul_1(rp, ap, an, bp[0]);
+  for (size_t i = 1; i < bn; ++i) {
+    rp[an + i] = limbs_addmul_1(rp + i, ap, an, bp[i]);
+  }
+}
+
+void limbs_sqr_basecase(uint64_t *rp, const uint64_t *ap, size_t n)
+{
+  // the cross products a[i]*a[j], i < j, each once, in rp[1..2n-1)
+  rp[0] = 0;
+  rp[2 * n - 1] = 0;
+  if (n > 1) {
+    rp[n] = limbs_mul_1(rp + 1, ap + 1, n - 1, ap[0]);
+    for (size_t i = 1; i + 1 < n; ++i) {
+      rp[n + i] = limbs_addmul_1(rp + 2 * i + 1, ap + i + 1, n - i - 1, ap[i]);
+    }
+  }
+
+  // doubled, plus the squares a[i]^2 on the diagonal, in one pass
+  uint64_t carry = 0, prev = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t lo = rp[2 * i], hi = rp[2 * i + 1];
+    uint128_t sq = (uint128_t) ap[i] * ap[i];
+    uint128_t sum = (uint128_t) ((lo << 1) | (prev >> 63)) + (uint64_t) sq + carry;
+    rp[2 * i] = (uint64_t) sum;
+    sum = (sum >> 64) + ((hi << 1) | (lo >> 63)) + (uint64_t) (sq >> 64);
+    rp[2 * i + 1] = (uint64_t) sum;
+    carry = (uint64_t) (sum >> 64);
+    prev = hi;
+  }
+}
+
+// Store |a - b| in rp[0..an), where an >= bn, and return 1 if the
+// difference is negative (a < b), 0 otherwise.
+static int limbs_abs_diff(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  bool a_bigger = limbs_normalized_size(ap + bn, an - bn) > 0;
+  if (a_bigger || limbs_cmp(ap, bp, bn) >= 0) {
+    limbs_sub(rp, ap, an, bp, bn);
+    return 0;
+  }
+  limbs_sub_n(rp, bp, ap, bn);
+  for (size_t i = bn; i < an; ++i) {
+    rp[i] = 0;
+  }
+  return 1;
+}
+
+// Arithmetic right shift by one bit of a two's complement value
+// rp[0..n).
+static void limbs_rshift1_signed(uint64_t *rp, size_t n)
+{
+  uint64_t fill = rp[n - 1] >> 63;
+  for (size_t i = n; i > 0; --i) {
+    uint64_t limb = rp[i - 1];
+    rp[i - 1] = (limb >> 1) | (fill << 63);
+    fill = limb & 1;
+  }
+}
+
+// Divide rp[0..n) by 3 in place, where the division is known to be
+// exact. Works modulo B^n, so two's complement values are fine too.
+static void limbs_divexact_by3(uint64_t *rp, size_t n)
+{
+  const uint64_t inv3 = 0xAAAAAAAAAAAAAAABUL; // 3 * inv3 == 1 (mod 2^64)
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t limb = rp[i];
+    uint64_t x = limb - borrow;
+    uint64_t q = x * inv3;
+    rp[i] = q;
+    borrow = (uint64_t) (((uint128_t) q * 3) >> 64) + (limb < borrow);
+  }
+}
+
+void limbs_negate(uint64_t *rp, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    rp[i] = ~rp[i];
+  }
+  limbs_add_1(rp, rp, n, 1);
+}
+
+static size_t karatsuba_scratch_size(size_t n)
+{
+  size_t m = n - n / 2;
+  return 4 * m + 1 + limbs_mul_n_scratch_size(m);
+}
+
+static size_t toom3_scratch_size(size_t n)
+{
+  size_t k = (n + 2) / 3;
+  return 12 * (k + 1) + limbs_mul_n_scratch_size(k + 1);
+}
+
+size_t limbs_mul_n_scratch_size(size_t n)
+{
+  if ((n < mul_karatsuba_threshold && n < sqr_karatsuba_threshold) || n < 4) {
+    return 0;
+  }
+  // either tier may be entered directly, so size for the larger one
+  // (squaring needs no more than the product at each tier)
+  size_t kara = karatsuba_scratch_size(n);
+  size_t toom = n >= 5 ? toom3_scratch_size(n) : 0;
+  return kara > toom ? kara : toom;
+}
+
+void limbs_mul_karatsuba(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n, uint64_t *scratch)
+{
+  // below 4 limbs, the high half of the result is too short to absorb
+  // the (2m+1)-limb middle term, whatever the threshold
+  if (n < mul_karatsuba_threshold || n < 4) {
+    limbs_mul_basecase(rp, ap, n, bp, n);
+    return;
+  }
+
+  // Split each operand into a low half of m limbs and a high half of
+  // s <= m limbs, so that a = a1*B^m + a0 and b = b1*B^m + b0. Then
+  //   a*b = a1*b1*B^2m + (a0*b0 + a1*b1 - (a0-a1)*(b0-b1))*B^m + a0*b0
+  // The differences are formed as magnitudes plus a sign, which keeps
+  // every intermediate product at m limbs.
+  size_t m = n - n / 2;
+  size_t s = n / 2;
+  const uint64_t *a0 = ap, *a1 = ap + m;
+  const uint64_t *b0 = bp, *b1 = bp + m;
+
+  uint64_t *t = scratch;               // (a0-a1)*(b0-b1), 2m limbs
+  uint64_t *da = scratch + 2 * m;      // |a0-a1|, m limbs
+  uint64_t *db = scratch + 3 * m;      // |b0-b1|, m limbs
+  uint64_t *u = scratch + 2 * m;       // middle term, 2m+1 limbs (reuses da/db)
+  uint64_t *next = scratch + 4 * m + 1;
+
+  int neg = limbs_abs_diff(da, a0, m, a1, s) ^ limbs_abs_diff(db, b0, m, b1, s);
+  limbs_mul_n(t, da, db, m, next);
+
+  limbs_mul_n(rp, a0, b0, m, next);
+  limbs_mul_n(rp + 2 * m, a1, b1, s, next);
+
+  u[2 * m] = limbs_add(u, rp, 2 * m, rp + 2 * m, 2 * s);
+  if (neg) {
+    u[2 * m] += limbs_add_n(u, u, t, 2 * m);
+  } else {
+    u[2 * m] -= limbs_sub_n(u, u, t, 2 * m);
+  }
+
+  limbs_add(rp + m, rp + m, 2 * n - m, u, 2 * m + 1);
+}
+
+// Interpolation of Toom-Cook 3-way: given v0 = c(0) in rp[0..2k),
+// vinf = c(inf) in rp[4k..2n), zeros in between, and c(1), c(-1) and
+// c(2) in v1, vm1 and v2 (w = 2k+2 limbs each, clobbered), complete
+// rp[0..2n) = c(B^k).
+static void toom3_interpolate(uint64_t *rp, uint64_t *v1, uint64_t *vm1, uint64_t *v2, size_t n, size_t k)
+{
+  size_t r = n - 2 * k;
+  size_t w = 2 * (k + 1);
+  const uint64_t *v0 = rp, *vinf = rp + 4 * k;
+
+  // Interpolate in w-limb two's complement, where the intermediate
+  // values may go negative:
+  //   c3 = ((v2 - vm1)/3 - (v1 - v0))/2 - 2*vinf
+  //   c2 = (v1 - v0) - (v1 - vm1)/2 - vinf
+  //   c1 = (v1 - vm1)/2 - c3
+  limbs_sub_n(v2, v2, vm1, w);
+  limbs_divexact_by3(v2, w);
+  limbs_sub_n(vm1, v1, vm1, w);
+  limbs_rshift1_signed(vm1, w);
+  limbs_sub(v1, v1, w, v0, 2 * k);
+  limbs_sub_n(v2, v2, v1, w);
+  limbs_rshift1_signed(v2, w);
+  limbs_sub(v2, v2, w, vinf, 2 * r);
+  limbs_sub(v2, v2, w, vinf, 2 * r);
+  limbs_sub_n(v1, v1, vm1, w);
+  limbs_sub(v1, v1, w, vinf, 2 * r);
+  limbs_sub_n(vm1, vm1, v2, w);
+
+  // c(x) = vinf*x^4 + c3*x^3 + c2*x^2 + c1*x + v0; the coefficients are
+  // all non-negative now and no longer than the room left above them
+  const uint64_t *c[] = { vm1, v1, v2 };
+  for (size_t i = 1; i <= 3; ++i) {
+    size_t len = limbs_normalized_size(c[i - 1], w);
+    limbs_add(rp + i * k, rp + i * k, 2 * n - i * k, c[i - 1], len);
+  }
+}
+
+void limbs_mul_toom3(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n, uint64_t *scratch)
+{
+  // n >= 5 guarantees a non-empty high part below
+  if (n < mul_toom3_threshold || n < 5) {
+    limbs_mul_karatsuba(rp, ap, bp, n, scratch);
+    return;
+  }
+
+  // Split into k-limb pieces a = a2*x^2 + a1*x + a0 with x = B^k
+  // (a2 has r <= k limbs), evaluate at 0, 1, -1, 2 and infinity,
+  // multiply pointwise, and interpolate the five coefficients of the
+  // product polynomial.
+  size_t k = (n + 2) / 3;
+  size_t r = n - 2 * k;
+  size_t e = k + 1;      // size of an evaluated operand
+  size_t w = 2 * e;      // size of a pointwise product
+  const uint64_t *a0 = ap, *a1 = ap + k, *a2 = ap + 2 * k;
+  const uint64_t *b0 = bp, *b1 = bp + k, *b2 = bp + 2 * k;
+
+  uint64_t *ae1 = scratch;           // a(1)
+  uint64_t *aem1 = scratch + e;      // |a(-1)|
+  uint64_t *ae2 = scratch + 2 * e;   // a(2)
+  uint64_t *be1 = scratch + 3 * e;
+  uint64_t *bem1 = scratch + 4 * e;
+  uint64_t *be2 = scratch + 5 * e;
+  uint64_t *v1 = scratch + 6 * e;
+  uint64_t *vm1 = v1 + w;
+  uint64_t *v2 = vm1 + w;
+  uint64_t *next = v2 + w;
+
+  // a(1) = a0 + a1 + a2, |a(-1)| = |a0 - a1 + a2|, a(2) = 2*(a(1) + a2) - a0
+  int neg = 0;
+  const uint64_t *x0[] = { a0, b0 }, *x1[] = { a1, b1 }, *x2[] = { a2, b2 };
+  uint64_t *xe1[] = { ae1, be1 }, *xem1[] = { aem1, bem1 }, *xe2[] = { ae2, be2 };
+  for (int j = 0; j < 2; ++j) {
+    uint64_t *s = xe2[j]; // a0 + a2, held in the a(2) slot for now
+    s[k] = limbs_add(s, x0[j], k, x2[j], r);
+    xe1[j][k] = s[k] + limbs_add_n(xe1[j], s, x1[j], k);
+    if (s[k] == 0 && limbs_cmp(s, x1[j], k) < 0) {
+      limbs_sub_n(xem1[j], x1[j], s, k);
+      xem1[j][k] = 0;
+      neg ^= 1;
+    } else {
+      xem1[j][k] = s[k] - limbs_sub_n(xem1[j], s, x1[j], k);
+    }
+    limbs_add(s, xe1[j], e, x2[j], r);
+    limbs_add_n(s, s, s, e);
+    limbs_sub(s, s, e, x0[j], k);
+  }
+
+  limbs_mul_n(v1, ae1, be1, e, next);
+  limbs_mul_n(vm1, aem1, bem1, e, next);
+  limbs_mul_n(v2, ae2, be2, e, next);
+  limbs_mul_n(rp, a0, b0, k, next);                  // v0
+  limbs_mul_n(rp + 4 * k, a2, b2, r, next);          // vinf
+  for (size_t i = 2 * k; i < 4 * k; ++i) {
+    rp[i] = 0;
+  }
+  if (neg) {
+    limbs_negate(vm1, w);
+  }
+  toom3_interpolate(rp, v1, vm1, v2, n, k);
+}
+
+void limbs_sqr_karatsuba(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t *scratch)
+{
+  // the minimum size is that of limbs_mul_karatsuba
+  if (n < sqr_karatsuba_threshold || n < 4) {
+    limbs_sqr_basecase(rp, ap, n);
+    return;
+  }
+
+  // As for the product with b = a, the middle term is
+  //   a0^2 + a1^2 - (a0-a1)^2
+  // where the square of the difference doesn't depend on its sign.
+  size_t m = n - n / 2;
+  size_t s = n / 2;
+  const uint64_t *a0 = ap, *a1 = ap + m;
+
+  uint64_t *t = scratch;               // (a0-a1)^2, 2m limbs
+  uint64_t *d = scratch + 2 * m;       // |a0-a1|, m limbs
+  uint64_t *u = scratch + 2 * m;       // middle term, 2m+1 limbs (reuses d)
+  uint64_t *next = scratch + 4 * m + 1;
+
+  limbs_abs_diff(d, a0, m, a1, s);
+  limbs_sqr_n(t, d, m, next);
+
+  limbs_sqr_n(rp, a0, m, next);
+  limbs_sqr_n(rp + 2 * m, a1, s, next);
+
+  u[2 * m] = limbs_add(u, rp, 2 * m, rp + 2 * m, 2 * s);
+  u[2 * m] -= limbs_sub_n(u, u, t, 2 * m);
+
+  limbs_add(rp + m, rp + m, 2 * n - m, u, 2 * m + 1);
+}
+
+void limbs_sqr_toom3(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t *scratch)
+{
+  if (n < sqr_toom3_threshold || n < 5) {
+    limbs_sqr_karatsuba(rp, ap, n, scratch);
+    return;
+  }
+
+  // The evaluation of limbs_mul_toom3 for a single operand; a(-1)^2 is
+  // non-negative whatever the sign of a(-1).
+  size_t k = (n + 2) / 3;
+  size_t r = n - 2 * k;
+  size_t e = k + 1;
+  size_t w = 2 * e;
+  const uint64_t *a0 = ap, *a1 = ap + k, *a2 = ap + 2 * k;
+
+  uint64_t *ae1 = scratch;           // a(1)
+  uint64_t *aem1 = scratch + e;      // |a(-1)|
+  uint64_t *ae2 = scratch + 2 * e;   // a(2)
+  uint64_t *v1 = scratch + 3 * e;
+  uint64_t *vm1 = v1 + w;
+  uint64_t *v2 = vm1 + w;
+  uint64_t *next = v2 + w;
+
+  uint64_t *s = ae2; // a0 + a2, held in the a(2) slot for now
+  s[k] = limbs_add(s, a0, k, a2, r);
+  ae1[k] = s[k] + limbs_add_n(ae1, s, a1, k);
+  if (s[k] == 0 && limbs_cmp(s, a1, k) < 0) {
+    limbs_sub_n(aem1, a1, s, k);
+    aem1[k] = 0;
+  } else {
+    aem1[k] = s[k] - limbs_sub_n(aem1, s, a1, k);
+  }
+  limbs_add(s, ae1, e, a2, r);
+  limbs_add_n(s, s, s, e);
+  limbs_sub(s, s, e, a0, k);
+
+  limbs_sqr_n(v1, ae1, e, next);
+  limbs_sqr_n(vm1, aem1, e, next);
+  limbs_sqr_n(v2, ae2, e, next);
+  limbs_sqr_n(rp, a0, k, next);                   // v0
+  limbs_sqr_n(rp + 4 * k, a2, r, next);           // vinf
+  for (size_t i = 2 * k; i < 4 * k; ++i) {
+    rp[i] = 0;
+  }
+  toom3_interpolate(rp, v1, vm1, v2, n, k);
+}
+
+void limbs_sqr_n(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t *scratch)
+{
+  if (n < sqr_karatsuba_threshold) {
+    limbs_sqr_basecase(rp, ap, n);
+  } else if (n < sqr_toom3_threshold) {
+    limbs_sqr_karatsuba(rp, ap, n, scratch);
+  } else if (n < mul_ntt_threshold) {
+    limbs_sqr_toom3(rp, ap, n, scratch);
+  } else {
+    limbs_mul_ntt(rp, ap, n, ap, n);
+  }
+}
+
+void limbs_sqr(uint64_t *rp, const uint64_t *ap, size_t n)
+{
+  if (n < sqr_karatsuba_threshold) {
+    limbs_sqr_basecase(rp, ap, n);
+    return;
+  }
+  if (n >= mul_ntt_threshold) {
+    limbs_mul_ntt(rp, ap, n, ap, n);
+    return;
+  }
+  std::vector<uint64_t> scratch(limbs_mul_n_scratch_size(n));
+  limbs_sqr_n(rp, ap, n, scratch.data());
+}
+
+void limbs_mul_n(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n, uint64_t *scratch)
+{
+  if (ap == bp) {
+    limbs_sqr_n(rp, ap, n, scratch);
+  } else if (n < mul_karatsuba_threshold) {
+    limbs_mul_basecase(rp, ap, n, bp, n);
+  } else if (n < mul_toom3_threshold) {
+    limbs_mul_karatsuba(rp, ap, bp, n, scratch);
+  } else if (n < mul_ntt_threshold) {
+    limbs_mul_toom3(rp, ap, bp, n, scratch);
+  } else {
+    limbs_mul_ntt(rp, ap, n, bp, n);
+  }
+}
+
+void limbs_mul(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  if (ap == bp && an == bn) {
+    limbs_sqr(rp, ap, an);
+    return;
+  }
+  if (bn < mul_karatsuba_threshold) {
+    limbs_mul_basecase(rp, ap, an, bp, bn);
+    return;
+  }
+  if (bn >= mul_ntt_threshold) {
+    limbs_mul_ntt(rp, ap, an, bp, bn);
+    return;
+  }
+
+  std::vector<uint64_t> scratch(limbs_mul_n_scratch_size(bn));
+  if (an == bn) {
+    limbs_mul_n(rp, ap, bp, bn, scratch.data());
+    return;
+  }
+
+  // Unbalanced operands: multiply b by successive bn-limb chunks of a
+  // so that each partial product stays balanced, and accumulate.
+  limbs_mul_n(rp, ap, bp, bn, scratch.data());
+  std::vector<uint64_t> partial(2 * bn);
+  for (size_t i = bn; i < an; i += bn) {
+    size_t chunk = an - i < bn ? an - i : bn;
+    if (chunk == bn) {
+      limbs_mul_n(partial.data(), ap + i, bp, bn, scratch.data());
+    } else {
+      limbs_mul(partial.data(), bp, bn, ap + i, chunk);
+    }
+    // rp[i..i+bn) already holds the high half of the previous partial
+    // product; everything above it is still uninitialized.
+    uint64_t carry = limbs_add_n(rp + i, rp + i, partial.data(), bn);
+    limbs_add_1(rp + i + bn, partial.data() + bn, chunk, carry);
+  }
+}
+
+uint64_t limbs_addmul(uint64_t *rp, size_t rn, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  if (bn < mul_karatsuba_threshold) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < bn; ++i) {
+      uint64_t hi = limbs_addmul_1(rp + i, ap, an, bp[i]);
+      carry += limbs_add_1(rp + i + an, rp + i + an, rn - i - an, hi);
+    }
+    return carry;
+  }
+  // Above the threshold, accumulate the product of b with each bn-limb
+  // chunk of a in turn, so that only one balanced partial product is
+  // held at a time.
+  std::vector<uint64_t> scratch(limbs_mul_n_scratch_size(bn)), partial(2 * bn);
+  uint64_t carry = 0;
+  for (size_t i = 0; i < an; i += bn) {
+    size_t chunk = an - i < bn ? an - i : bn;
+    if (chunk == bn) {
+      limbs_mul_n(partial.data(), ap + i, bp, bn, scratch.data());
+    } else {
+      limbs_mul(partial.data(), bp, bn, ap + i, chunk);
+    }
+    carry += limbs_add(rp + i, rp + i, rn - i, partial.data(), bn + chunk);
+  }
+  return carry;
+}
+
+uint64_t limbs_submul(uint64_t *rp, size_t rn, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  if (bn < mul_karatsuba_threshold) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < bn; ++i) {
+      uint64_t hi = limbs_submul_1(rp + i, ap, an, bp[i]);
+      borrow += limbs_sub_1(rp + i + an, rp + i + an, rn - i - an, hi);
+    }
+    return borrow;
+  }
+  // Above the threshold, accumulate the product of b with each bn-limb
+  // chunk of a in turn, so that only one balanced partial product is
+  // held at a time.
+  std::vector<uint64_t> scratch(limbs_mul_n_scratch_size(bn)), partial(2 * bn);
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < an; i += bn) {
+    size_t chunk = an - i < bn ? an - i : bn;
+    if (chunk == bn) {
+      limbs_mul_n(partial.data(), ap + i, bp, bn, scratch.data());
+    } else {
+      limbs_mul(partial.data(), bp, bn, ap + i, chunk);
+    }
+    borrow += limbs_sub(rp + i, rp + i, rn - i, partial.data(), bn + chunk);
+  }
+  return borrow;
+}
+
+uint64_t limbs_divrem_1(uint64_t *qp, const uint64_t *ap, size_t n, uint64_t d)
+{
+  uint64_t rem = 0;
+  for (size_t i = n; i > 0; --i) {
+    uint128_t num = ((uint128_t) rem << 64) | ap[i - 1];
+    qp[i - 1] = (uint64_t) (num / d);
+    rem = (uint64_t) (num % d);
+  }
+  return rem;
+}
+
+void limbs_div_qr_schoolbook(uint64_t *qp, uint64_t *rp, const uint64_t *np, size_t nn, const uint64_t *dp, size_t dn)
+{
+  if (dn == 1) {
+    std::vector<uint64_t> q(nn);
+    uint64_t rem = limbs_divrem_1(q.data(), np, nn, dp[0]);
+    if (qp) {
+      for (size_t i = 0; i < nn; ++i) {
+        qp[i] = q[i];
+      }
+    }
+    if (rp) {
+      rp[0] = rem;
+    }
+    return;
+  }
+
+  // Normalize so that the divisor's top bit is set; this keeps each
+  // trial quotient within 2 of the true quotient digit.
+  unsigned shift = __builtin_clzll(dp[dn - 1]);
+  std::vector<uint64_t> d(dp, dp + dn);
+  std::vector<uint64_t> u(nn + 1);
+  if (shift != 0) {
+    limbs_lshift(d.data(), dp, dn, shift);
+    u[nn] = limbs_lshift(u.data(), np, nn, shift);
+  } else {
+    for (size_t i = 0; i < nn; ++i) {
+      u[i] = np[i];
+    }
+  }
+
+  uint64_t d1 = d[dn - 1], d2 = d[dn - 2];
+  for (size_t j = nn - dn + 1; j > 0; --j) {
+    uint64_t *uj = u.data() + j - 1;
+    uint64_t top = uj[dn], next = uj[dn - 1];
+
+    // trial quotient from the top two limbs of the current remainder,
+    // refined with the divisor's second limb
+    uint64_t qhat, rhat;
+    bool rhat_overflow = false;
+    if (top >= d1) {
+      qhat = UINT64_MAX;
+      rhat = next + d1;
+      rhat_overflow = rhat < d1;
+    } else {
+      uint128_t num = ((uint128_t) top << 64) | next;
+      qhat = (uint64_t) (num / d1);
+      rhat = (uint64_t) (num % d1);
+    }
+    while (!rhat_overflow &&
+           (uint128_t) qhat * d2 > (((uint128_t) rhat << 64) | uj[dn - 2])) {
+      --qhat;
+      rhat += d1;
+      rhat_overflow = rhat < d1;
+    }
+
+    uint64_t borrow = limbs_submul_1(uj, d.data(), dn, qhat);
+    if (top < borrow) {
+      // qhat was one too large (rare): add the divisor back
+      --qhat;
+      limbs_add_n(uj, uj, d.data(), dn);
+    }
+    uj[dn] = 0;
+    if (qp) {
+      qp[j - 1] = qhat;
+    }
+  }
+
+  if (rp) {
+    if (shift != 0) {
+      limbs_rshift(rp, u.data(), dn, shift);
+    } else {
+      for (size_t i = 0; i < dn; ++i) {
+        rp[i] = u[i];
+      }
+    }
+  }
+}
+
+// Divide np[0..2n) by the normalized dp[0..n) with schoolbook long
+// division, leaving the quotient in qp[0..n) and the remainder in
+// np[0..n). Returns the quotient's extra high limb (0 or 1).
+static uint64_t div_qr_basecase_n(uint64_t *qp, uint64_t *np, const uint64_t *dp, size_t n)
+{
+  uint64_t qh = limbs_cmp(np + n, dp, n) >= 0;
+  if (qh) {
+    limbs_sub_n(np + n, np + n, dp, n);
+  }
+  // the high half is now below the divisor, so the top quotient limb
+  // computed here is always zero
+  std::vector<uint64_t> q(n + 1);
+  limbs_div_qr_schoolbook(q.data(), np, np, 2 * n, dp, n);
+  for (size_t i = 0; i < n; ++i) {
+    qp[i] = q[i];
+  }
+  return qh;
+}
+
+static uint64_t div_qr_n(uint64_t *qp, uint64_t *np, const uint64_t *dp, size_t n, uint64_t *tp);
+
+// The recursive step: np[0..2n) / dp[0..n) as two divisions of 3h
+// limbs by 2h limbs, each done as a recursive division by the high
+// half of the divisor followed by a correction with its low half.
+// Same contract as div_qr_basecase_n; tp must have room for n limbs.
+static uint64_t div_qr_bz_n(uint64_t *qp, uint64_t *np, const uint64_t *dp, size_t n, uint64_t *tp)
+{
+  size_t lo = n / 2, hi = n - lo;
+
+  // high hi limbs of the quotient, from the top 2*hi limbs of np and
+  // the top hi limbs of the divisor; the estimate is at most a couple
+  // too large since the divisor is normalized
+  uint64_t qh = div_qr_n(qp + lo, np + 2 * lo, dp + lo, hi, tp);
+  limbs_mul(tp, qp + lo, hi, dp, lo);
+  uint64_t cy = limbs_sub_n(np + lo, np + lo, tp, n);
+  if (qh) {
+    cy += limbs_sub_n(np + n, np + n, dp, lo);
+  }
+  while (cy != 0) {
+    qh -= limbs_sub_1(qp + lo, qp + lo, hi, 1);
+    cy -= limbs_add_n(np + lo, np + lo, dp, n);
+  }
+
+  // low lo limbs of the quotient, the same way from what remains
+  uint64_t ql = div_qr_n(qp, np + hi, dp + hi, lo, tp);
+  limbs_mul(tp, dp, hi, qp, lo);
+  cy = limbs_sub_n(np, np, tp, n);
+  if (ql) {
+    cy += limbs_sub_n(np + lo, np + lo, dp, hi);
+  }
+  while (cy != 0) {
+    limbs_sub_1(qp, qp, lo, 1);
+    cy -= limbs_add_n(np, np, dp, n);
+  }
+
+  return qh;
+}
+
+static uint64_t div_qr_n(uint64_t *qp, uint64_t *np, const uint64_t *dp, size_t n, uint64_t *tp)
+{
+  if (n < div_bz_threshold || n < 2) {
+    return div_qr_basecase_n(qp, np, dp, n);
+  }
+  return div_qr_bz_n(qp, np, dp, n, tp);
+}
+
+void limbs_div_qr_bz(uint64_t *qp, uint64_t *rp, const uint64_t *np, size_t nn, const uint64_t *dp, size_t dn)
+{
+  // Normalize into u (with one extra limb, so that the quotient of u
+  // by d has exactly un - dn limbs and no extra high limb).
+  unsigned shift = __builtin_clzll(dp[dn - 1]);
+  size_t un = nn + 1;
+  std::vector<uint64_t> d(dp, dp + dn);
+  std::vector<uint64_t> u(np, np + nn);
+  u.push_back(0);
+  if (shift != 0) {
+    limbs_lshift(d.data(), dp, dn, shift);
+    u[nn] = limbs_lshift(u.data(), np, nn, shift);
+  }
+
+  size_t qn = un - dn;
+  std::vector<uint64_t> q(qn);
+  std::vector<uint64_t> tp(dn);
+
+  // The quotient is produced in blocks of dn limbs from the top down,
+  // each from a 2dn-limb window of u. The topmost block, of b <= dn
+  // limbs, is estimated from the top b limbs of d and then corrected.
+  size_t b = qn % dn == 0 ? dn : qn % dn;
+  size_t pos = qn - b;
+  uint64_t qh = div_qr_n(q.data() + pos, u.data() + pos + dn - b, d.data() + dn - b, b, tp.data());
+  if (b != dn) {
+    if (b >= dn - b) {
+      limbs_mul(tp.data(), q.data() + pos, b, d.data(), dn - b);
+    } else {
+      limbs_mul(tp.data(), d.data(), dn - b, q.data() + pos, b);
+    }
+    uint64_t cy = limbs_sub_n(u.data() + pos, u.data() + pos, tp.data(), dn);
+    if (qh) {
+      cy += limbs_sub_n(u.data() + pos + b, u.data() + pos + b, d.data(), dn - b);
+    }
+    while (cy != 0) {
+      qh -= limbs_sub_1(q.data() + pos, q.data() + pos, b, 1);
+      cy -= limbs_add_n(u.data() + pos, u.data() + pos, d.data(), dn);
+    }
+  }
+  while (pos > 0) {
+    pos -= dn;
+    div_qr_n(q.data() + pos, u.data() + pos, d.data(), dn, tp.data());
+  }
+
+  if (qp) {
+    for (size_t i = 0; i < qn; ++i) {
+      qp[i] = q[i];
+    }
+  }
+  if (rp) {
+    if (shift != 0) {
+      limbs_rshift(rp, u.data(), dn, shift);
+    } else {
+      for (size_t i = 0; i < dn; ++i) {
+        rp[i] = u[i];
+      }
+    }
+  }
+}
+
+void limbs_div_qr(uint64_t *qp, uint64_t *rp, const uint64_t *np, size_t nn, const uint64_t *dp, size_t dn)
+{
+  // The recursion only pays off when both the divisor and the quotient
+  // are long; a short quotient is a few submul_1 passes anyway.
+  if (dn < div_bz_threshold || nn - dn + 1 < div_bz_threshold) {
+    limbs_div_qr_schoolbook(qp, rp, np, nn, dp, dn);
+  } else {
+    limbs_div_qr_bz(qp, rp, np, nn, dp, dn);
+  }
+}
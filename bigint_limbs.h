@@ -0,0 +1,342 @@
+#ifndef BIGINT_LIMBS_H
+#define BIGINT_LIMBS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! @file
+//! Low-level kernels operating on little-endian arrays of `uint64_t`
+//! limbs. These are the building blocks used by the BigInt arithmetic
+//! operators. Unless noted otherwise, the result array must not
+//! overlap the operand arrays, and sizes are counts of limbs.
+
+//! Limb count at or above which balanced multiplication switches
+//! from the schoolbook kernel to Karatsuba. Karatsuba needs at least
+//! 4 limbs, so smaller operands use the schoolbook kernel even if the
+//! threshold is lower.
+extern size_t mul_karatsuba_threshold;
+
+//! Limb count at or above which balanced multiplication switches
+//! from Karatsuba to Toom-Cook 3-way. Toom-3 needs at least 5 limbs,
+//! so smaller operands use Karatsuba even if the threshold is lower.
+extern size_t mul_toom3_threshold;
+
+//! Limb count at or above which squaring switches from the schoolbook
+//! squaring kernel to Karatsuba squaring. As for
+//! `mul_karatsuba_threshold`, operands below 4 limbs are always squared
+//! with the schoolbook kernel.
+extern size_t sqr_karatsuba_threshold;
+
+//! Limb count at or above which squaring switches from Karatsuba to
+//! Toom-Cook 3-way squaring, from 5 limbs up as for
+//! `mul_toom3_threshold`.
+extern size_t sqr_toom3_threshold;
+
+//! Limb count of the smaller operand at or above which multiplication
+//! switches to the number-theoretic transform.
+extern size_t mul_ntt_threshold;
+
+//! Divisor limb count (and quotient limb count) at or above which
+//! division switches from schoolbook long division to the recursive
+//! Burnikel-Ziegler algorithm.
+extern size_t div_bz_threshold;
+
+//! Limb count of the operands at or above which the GCD algorithms
+//! reduce them with the half-GCD recursion instead of Lehmer's
+//! algorithm.
+extern size_t gcd_dc_threshold;
+
+//! Number of limbs by which the half-GCD must reduce its operands for
+//! it to recurse (below that, it takes Lehmer steps).
+extern size_t gcd_hgcd_threshold;
+
+//! Limb count at or above which decimal conversion splits the value
+//! recursively instead of peeling off 19 digits at a time.
+extern size_t to_dec_dc_threshold;
+
+//! Number of 19-digit chunks at or above which decimal parsing combines
+//! the chunks recursively instead of by Horner's rule.
+extern size_t from_dec_dc_threshold;
+
+//! Limb count of the modulus at or above which `BigIntModContext`
+//! reduces products by Barrett reduction instead of by division.
+extern size_t mod_barrett_threshold;
+
+//! Return true if the CPU supports the BMI2 and ADX instruction set
+//! extensions (checked with CPUID) and this build includes the x86-64
+//! assembly kernels that use them.
+bool limbs_asm_supported();
+
+//! If true, `limbs_add_n`, `limbs_sub_n`, `limbs_mul_1`,
+//! `limbs_addmul_1` and `limbs_submul_1` run their assembly versions
+//! instead of the portable C++ loops. Initialized at startup to
+//! `limbs_asm_supported()`; may be cleared (e.g. to compare the two),
+//! but must not be set unless `limbs_asm_supported()` is true.
+extern bool limbs_asm_enabled;
+
+//! Compare two limb arrays of the same length.
+//!
+//! @return negative if a < b, 0 if a == b, positive if a > b
+int limbs_cmp(const uint64_t *ap, const uint64_t *bp, size_t n);
+
+//! Return the number of limbs in `ap[0..n)` once high zero limbs are
+//! discarded (0 if every limb is zero).
+size_t limbs_normalized_size(const uint64_t *ap, size_t n);
+
+//! rp[0..n) = ap[0..n) + bp[0..n). `rp` may alias `ap` or `bp`.
+//!
+//! @return the carry out of the most significant limb (0 or 1)
+uint64_t limbs_add_n(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n);
+
+//! rp[0..an) = ap[0..an) + bp[0..bn), where an >= bn. `rp` may alias `ap`.
+//!
+//! @return the carry out of the most significant limb (0 or 1)
+uint64_t limbs_add(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn);
+
+//! rp[0..n) = ap[0..n) + b. `rp` may alias `ap`.
+//!
+//! @return the carry out of the most significant limb (0 or 1)
+uint64_t limbs_add_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+
+//! rp[0..n) = ap[0..n) - bp[0..n). `rp` may alias `ap` or `bp`.
+//!
+//! @return the borrow out of the most significant limb (0 or 1)
+uint64_t limbs_sub_n(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n);
+
+//! rp[0..an) = ap[0..an) - bp[0..bn), where an >= bn. `rp` may alias `ap`.
+//!
+//! @return the borrow out of the most significant limb (0 or 1)
+uint64_t limbs_sub(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn);
+
+//! rp[0..n) = ap[0..n) - b. `rp` may alias `ap`.
+//!
+//! @return the borrow out of the most significant limb (0 or 1)
+uint64_t limbs_sub_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+
+//! Negate the two's complement value rp[0..n) in place.
+void limbs_negate(uint64_t *rp, size_t n);
+
+//! rp[0..n) = ap[0..n) * b. `rp` may alias `ap`.
+//!
+//! @return the high limb of the product
+uint64_t limbs_mul_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+
+//! rp[0..n) += ap[0..n) * b.
+//!
+//! @return the limb carried out of rp[n-1]
+uint64_t limbs_addmul_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+
+//! rp[0..n) -= ap[0..n) * b.
+//!
+//! @return the limb borrowed out of rp[n-1]
+uint64_t limbs_submul_1(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t b);
+
+//! rp[0..n) = ap[0..n) << cnt, where 0 < cnt < 64. `rp` may alias `ap`,
+//! or overlap it from above (rp > ap), as when shifting limbs upwards
+//! within one array.
+//!
+//! @return the bits shifted out of the most significant limb
+uint64_t limbs_lshift(uint64_t *rp, const uint64_t *ap, size_t n, unsigned cnt);
+
+//! rp[0..n) = ap[0..n) >> cnt, where 0 < cnt < 64. `rp` may alias `ap`,
+//! or overlap it from below (rp < ap), as when shifting limbs downwards
+//! within one array.
+//!
+//! @return the bits shifted out of the least significant limb, in the
+//!         high bits of the returned limb
+uint64_t limbs_rshift(uint64_t *rp, const uint64_t *ap, size_t n, unsigned cnt);
+
+//! rp[0..an) = (ap[0..an) + bp[0..bn)) << cnt, where an >= bn and
+//! 0 <= cnt < 64, in a single pass over the operands.
+//!
+//! @return the high limb of the result (the carry out of the sum and
+//!         the bits shifted out of the most significant limb)
+uint64_t limbs_add_lshift(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn, unsigned cnt);
+
+//! rp[0..an) = (ap[0..an) - bp[0..bn)) << cnt, where an >= bn,
+//! ap >= bp and 0 <= cnt < 64, in a single pass over the operands.
+//!
+//! @return the bits shifted out of the most significant limb
+uint64_t limbs_sub_lshift(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn, unsigned cnt);
+
+//! Schoolbook product rp[0..an+bn) = ap[0..an) * bp[0..bn),
+//! where an >= bn >= 1.
+void limbs_mul_basecase(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn);
+
+//! Karatsuba product rp[0..2n) = ap[0..n) * bp[0..n), using
+//! `scratch` (at least `limbs_mul_n_scratch_size(n)` limbs) for
+//! intermediate values. Falls back to the schoolbook kernel below
+//! `mul_karatsuba_threshold`.
+void limbs_mul_karatsuba(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n, uint64_t *scratch);
+
+//! Toom-Cook 3-way product rp[0..2n) = ap[0..n) * bp[0..n), using
+//! `scratch` (at least `limbs_mul_n_scratch_size(n)` limbs) for
+//! intermediate values. Falls back to Karatsuba below
+//! `mul_toom3_threshold`.
+void limbs_mul_toom3(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n, uint64_t *scratch);
+
+//! Product rp[0..an+bn) = ap[0..an) * bp[0..bn) by number-theoretic
+//! transform over three 62-bit primes, for an, bn >= 1. Quasi-linear
+//! in an + bn; allocates its own working storage (about 4x the
+//! product size, rounded up to a power of two). A square (`ap == bp`
+//! and `an == bn`) takes one forward transform per prime instead of
+//! two.
+void limbs_mul_ntt(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn);
+
+//! Number of scratch limbs needed by `limbs_mul_n` (or `limbs_sqr_n`)
+//! for operands of `n` limbs.
+size_t limbs_mul_n_scratch_size(size_t n);
+
+//! Balanced product rp[0..2n) = ap[0..n) * bp[0..n), dispatching on
+//! `n` to the fastest available algorithm. If `ap == bp`, this is
+//! `limbs_sqr_n`.
+void limbs_mul_n(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, size_t n, uint64_t *scratch);
+
+//! General product rp[0..an+bn) = ap[0..an) * bp[0..bn), where
+//! an >= bn >= 1. Allocates whatever scratch space the selected
+//! algorithm needs. If `ap == bp` and `an == bn`, this is `limbs_sqr`.
+void limbs_mul(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn);
+
+//! Schoolbook square rp[0..2n) = ap[0..n)^2, for n >= 1. Each cross
+//! product a[i]*a[j] (i < j) is computed once and doubled, so this
+//! takes about half the limb multiplications of `limbs_mul_basecase`.
+void limbs_sqr_basecase(uint64_t *rp, const uint64_t *ap, size_t n);
+
+//! Karatsuba square rp[0..2n) = ap[0..n)^2, using `scratch` (at least
+//! `limbs_mul_n_scratch_size(n)` limbs). Three half-size squares
+//! replace the three half-size products of `limbs_mul_karatsuba`.
+//! Falls back to the schoolbook kernel below `sqr_karatsuba_threshold`.
+void limbs_sqr_karatsuba(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t *scratch);
+
+//! Toom-Cook 3-way square rp[0..2n) = ap[0..n)^2, using `scratch` (at
+//! least `limbs_mul_n_scratch_size(n)` limbs); the operand is evaluated
+//! once and the five pointwise products are squares. Falls back to
+//! Karatsuba below `sqr_toom3_threshold`.
+void limbs_sqr_toom3(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t *scratch);
+
+//! Square rp[0..2n) = ap[0..n)^2, dispatching on `n` to the fastest
+//! available algorithm.
+void limbs_sqr_n(uint64_t *rp, const uint64_t *ap, size_t n, uint64_t *scratch);
+
+//! Square rp[0..2n) = ap[0..n)^2, for n >= 1. Allocates whatever
+//! scratch space the selected algorithm needs.
+void limbs_sqr(uint64_t *rp, const uint64_t *ap, size_t n);
+
+//! rp[0..rn) += ap[0..an) * bp[0..bn), where an >= bn >= 1 and
+//! rn >= an + bn. Below `mul_karatsuba_threshold` the product is
+//! accumulated row by row without being stored separately; above it,
+//! the product of b with each bn-limb chunk of a is formed in a
+//! 2bn-limb temporary and added in, one chunk at a time.
+//!
+//! @return the carry out of rp[rn-1]
+uint64_t limbs_addmul(uint64_t *rp, size_t rn, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn);
+
+//! rp[0..rn) -= ap[0..an) * bp[0..bn), with the same conditions as
+//! `limbs_addmul`.
+//!
+//! @return the borrow out of rp[rn-1] (if non-zero, rp holds the
+//!         difference in two's complement)
+uint64_t limbs_submul(uint64_t *rp, size_t rn, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn);
+
+//! Divide ap[0..n) by the single limb d != 0, storing the quotient in
+//! qp[0..n). `qp` may alias `ap`.
+//!
+//! @return the remainder
+uint64_t limbs_divrem_1(uint64_t *qp, const uint64_t *ap, size_t n, uint64_t d);
+
+//! Schoolbook long division (Knuth, TAOCP vol. 2, 4.3.1, Algorithm D):
+//! qp[0..nn-dn+1) = np[0..nn) / dp[0..dn) and rp[0..dn) = the
+//! remainder, where nn >= dn >= 1 and dp[dn-1] != 0. Either of `qp`
+//! and `rp` may be null if that part of the result is not wanted.
+void limbs_div_qr_schoolbook(uint64_t *qp, uint64_t *rp, const uint64_t *np, size_t nn, const uint64_t *dp, size_t dn);
+
+//! Recursive division (Burnikel and Ziegler, "Fast Recursive
+//! Division", 1998), with the same contract as
+//! `limbs_div_qr_schoolbook`. The quotient is produced in blocks of
+//! dn limbs, each by two half-size recursive divisions plus
+//! multiplications, so the cost is a small multiple of the
+//! multiplication time.
+void limbs_div_qr_bz(uint64_t *qp, uint64_t *rp, const uint64_t *np, size_t nn, const uint64_t *dp, size_t dn);
+
+//! Division with the same contract as `limbs_div_qr_schoolbook`,
+//! dispatching on the operand sizes to the fastest algorithm.
+void limbs_div_qr(uint64_t *qp, uint64_t *rp, const uint64_t *np, size_t nn, const uint64_t *dp, size_t dn);
+
+//! Return -m0^-1 mod 2^64 for an odd limb `m0`: the constant used by
+//! Montgomery reduction modulo a number whose lowest limb is `m0`.
+uint64_t limbs_mont_inverse(uint64_t m0);
+
+//! Montgomery reduction: rp[0..n) = tp[0..2n) / R mod mp[0..n), where
+//! R = 2^(64n), the modulus is odd, and t < m*R (e.g., the product of
+//! two values less than m). The result is fully reduced (less than m).
+//! `tp` is used as working space and destroyed.
+//!
+//! @param minv `limbs_mont_inverse(mp[0])`
+void limbs_redc(uint64_t *rp, uint64_t *tp, const uint64_t *mp, size_t n, uint64_t minv);
+
+//! Number of scratch limbs needed by `limbs_mont_mul` for an n-limb
+//! modulus.
+size_t limbs_mont_mul_scratch_size(size_t n);
+
+//! Montgomery product rp[0..n) = ap * bp / R mod mp, for ap, bp < mp
+//! (n limbs each) and odd mp. `rp` may alias `ap` or `bp`.
+//!
+//! @param minv `limbs_mont_inverse(mp[0])`
+//! @param scratch at least `limbs_mont_mul_scratch_size(n)` limbs
+void limbs_mont_mul(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, const uint64_t *mp, size_t n,
+                    uint64_t minv, uint64_t *scratch);
+
+//! Return the reciprocal floor((2^128 - 1) / d) - 2^64 of a limb `d`
+//! with its top bit set, as used by `limbs_mod_preinv`.
+uint64_t limbs_invert_limb(uint64_t d);
+
+//! Schoolbook remainder with a precomputed reciprocal: reduce
+//! up[0..un) in place modulo dp[0..n), leaving the remainder in
+//! up[0..n) (the higher limbs are cleared). The divisor must have its
+//! top bit set, `dinv` must be `limbs_invert_limb(dp[n-1])`, and the
+//! top n limbs of up must be less than the divisor (e.g. un-1 limbs
+//! shifted left so that up[un-1] holds the bits shifted out).
+void limbs_mod_preinv(uint64_t *up, size_t un, const uint64_t *dp, size_t n, uint64_t dinv);
+
+//! Return ap[0..n) mod d, for n >= 1 and a single limb d != 0. Unlike
+//! `limbs_divrem_1`, this stores no quotient and estimates each step
+//! with the reciprocal of (the normalized) d instead of a hardware
+//! division.
+uint64_t limbs_mod_1(const uint64_t *ap, size_t n, uint64_t d);
+
+//! Modular exponentiation rp[0..n) = bp[0..bn)^ep[0..en) mod mp[0..n),
+//! where mp[n-1] != 0 (the base need not be reduced). The exponent is
+//! scanned in sliding windows over precomputed odd powers; products
+//! are reduced by Montgomery reduction if the modulus is odd and by
+//! division otherwise.
+void limbs_powm(uint64_t *rp, const uint64_t *bp, size_t bn, const uint64_t *ep, size_t en,
+                const uint64_t *mp, size_t n);
+
+//! Return 10^(19*2^k) as a normalized limb array. The powers are
+//! computed on first use (by repeated squaring) and cached for the
+//! lifetime of the program; the returned reference stays valid.
+//! Safe to call from multiple threads.
+const std::vector<uint64_t> &limbs_pow10_cached(unsigned k);
+
+//! Append the decimal digits of ap[0..n) to `out`, without a sign and
+//! without leading zeros ("0" if the value is zero).
+void limbs_to_dec(std::string &out, const uint64_t *ap, size_t n);
+
+//! Parse the decimal digits str[0..len) (no sign, len >= 1) into
+//! rp[0..(len+18)/19). Leading zeros are allowed.
+//!
+//! @return false if the string contains anything but the digits 0-9
+//!         (the contents of `rp` are then unspecified), true otherwise
+bool limbs_from_dec(uint64_t *rp, const char *str, size_t len);
+
+//! Parse the hexadecimal digits str[0..len) (no sign or prefix,
+//! len >= 1, either case) into rp[0..(len+15)/16).
+//!
+//! @return false if the string contains anything but hexadecimal
+//!         digits (the contents of `rp` are then unspecified), true
+//!         otherwise
+bool limbs_from_hex(uint64_t *rp, const char *str, size_t len);
+
+#endif // BIGINT_LIMBS_H
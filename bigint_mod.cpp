@@ -0,0 +1,426 @@
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "bigint_limbs.h"
+#include "bigint_mod.h"
+
+//! @file
+//! Modular arithmetic: Montgomery and Barrett reduction and modular
+//! exponentiation on limb arrays, and the BigIntModContext class.
+
+typedef unsigned __int128 uint128_t;
+
+// Timed with mulmod on random operands. Below about 100 limbs,
+// division by the preinverted modulus is 10-30% faster than Barrett
+// reduction, whose two full products do more work than the quotient
+// needs; from there on the two are within noise of each other, and
+// Barrett reduction avoids setting up a division on each call.
+size_t mod_barrett_threshold = 200;
+
+uint64_t limbs_mont_inverse(uint64_t m0)
+{
+  uint64_t inv = m0; // correct to 3 bits (m0 is odd); each step doubles that
+  for (int i = 0; i < 5; ++i) {
+    inv *= 2 - m0 * inv;
+  }
+  return -inv;
+}
+
+void limbs_redc(uint64_t *rp, uint64_t *tp, const uint64_t *mp, size_t n, uint64_t minv)
+{
+  // Each step adds the multiple of m that clears the lowest remaining
+  // limb of t. The carry out of the step belongs n limbs higher; it is
+  // parked in the limb just cleared and added in at the end.
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t u = tp[i] * minv;
+    tp[i] = limbs_addmul_1(tp + i, mp, n, u);
+  }
+  uint64_t carry = limbs_add_n(rp, tp + n, tp, n);
+  if (carry != 0 || limbs_cmp(rp, mp, n) >= 0) {
+    limbs_sub_n(rp, rp, mp, n);
+  }
+}
+
+size_t limbs_mont_mul_scratch_size(size_t n)
+{
+  return 2 * n + limbs_mul_n_scratch_size(n);
+}
+
+void limbs_mont_mul(uint64_t *rp, const uint64_t *ap, const uint64_t *bp, const uint64_t *mp, size_t n,
+                    uint64_t minv, uint64_t *scratch)
+{
+  limbs_mul_n(scratch, ap, bp, n, scratch + 2 * n);
+  limbs_redc(rp, scratch, mp, n, minv);
+}
+
+uint64_t limbs_invert_limb(uint64_t d)
+{
+  return (uint64_t) ((((uint128_t) ~d) << 64 | UINT64_MAX) / d);
+}
+
+// Divide u1:u0 by d, where u1 < d, d has its top bit set, and
+// v = limbs_invert_limb(d), storing the remainder in r (Moller and
+// Granlund, "Improved Division by Invariant Integers", 2011,
+// Algorithm 4): the quotient is estimated with one multiplication and
+// corrected at most twice, instead of a 128-bit division.
+static inline uint64_t div_2by1_preinv(uint64_t &r, uint64_t u1, uint64_t u0, uint64_t d, uint64_t v)
+{
+  uint128_t q = (uint128_t) v * u1 + (((uint128_t) u1 << 64) | u0);
+  uint64_t q1 = (uint64_t) (q >> 64) + 1, q0 = (uint64_t) q;
+  r = u0 - q1 * d;
+  if (r > q0) {
+    --q1;
+    r += d;
+  }
+  if (r >= d) {
+    ++q1;
+    r -= d;
+  }
+  return q1;
+}
+
+void limbs_mod_preinv(uint64_t *up, size_t un, const uint64_t *dp, size_t n, uint64_t dinv)
+{
+  uint64_t d1 = dp[n - 1];
+  if (n == 1) {
+    uint64_t r = up[un - 1];
+    for (size_t i = un - 1; i > 0; --i) {
+      div_2by1_preinv(r, r, up[i - 1], d1, dinv);
+    }
+    up[0] = r;
+    return;
+  }
+
+  // as in limbs_div_qr_schoolbook, with the trial quotient digit
+  // computed from the reciprocal
+  uint64_t d2 = dp[n - 2];
+  for (size_t j = un - n; j > 0; --j) {
+    uint64_t *uj = up + j - 1;
+    uint64_t top = uj[n], next = uj[n - 1];
+
+    uint64_t qhat, rhat;
+    bool rhat_overflow = false;
+    if (top >= d1) {
+      qhat = UINT64_MAX;
+      rhat = next + d1;
+      rhat_overflow = rhat < d1;
+    } else {
+      qhat = div_2by1_preinv(rhat, top, next, d1, dinv);
+    }
+    while (!rhat_overflow &&
+           (uint128_t) qhat * d2 > (((uint128_t) rhat << 64) | uj[n - 2])) {
+      --qhat;
+      rhat += d1;
+      rhat_overflow = rhat < d1;
+    }
+
+    uint64_t borrow = limbs_submul_1(uj, dp, n, qhat);
+    if (top < borrow) {
+      limbs_add_n(uj, uj, dp, n);
+    }
+    uj[n] = 0;
+  }
+}
+
+uint64_t limbs_mod_1(const uint64_t *ap, size_t n, uint64_t d)
+{
+  // a mod d = ((a << shift) mod (d << shift)) >> shift, where the
+  // shifted a is streamed from the top limb down
+  unsigned shift = __builtin_clzll(d);
+  uint64_t dn = d << shift;
+  uint64_t dinv = limbs_invert_limb(dn);
+  uint64_t r = shift != 0 ? ap[n - 1] >> (64 - shift) : 0;
+  for (size_t i = n; i > 0; --i) {
+    uint64_t u0 = ap[i - 1] << shift;
+    if (shift != 0 && i > 1) {
+      u0 |= ap[i - 2] >> (64 - shift);
+    }
+    div_2by1_preinv(r, r, u0, dn, dinv);
+  }
+  return r >> shift;
+}
+
+// Window width for an exponent of the given bit length: wider windows
+// save multiplications but cost 2^(k-1) precomputed powers.
+static unsigned pow_window_bits(size_t bits)
+{
+  return bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : bits > 7 ? 2 : 1;
+}
+
+static unsigned exp_bit(const uint64_t *ep, size_t i)
+{
+  return (ep[i / 64] >> (i % 64)) & 1;
+}
+
+// rp[0..n) = g^e, for e = ep[0..en) with ep[en-1] != 0, scanning the
+// exponent from the top in windows of up to k bits that end in a set
+// bit, so that only the odd powers of g need to be precomputed.
+// mul(rp, ap, bp) must compute the n-limb product of ap and bp in
+// whatever representation g is in; rp may alias ap or bp.
+template <typename Mul>
+static void pow_sliding_window(uint64_t *rp, const uint64_t *gp, const uint64_t *ep, size_t en, size_t n, Mul mul)
+{
+  size_t bits = 64 * en - __builtin_clzll(ep[en - 1]);
+  unsigned k = pow_window_bits(bits);
+
+  // table[j] = g^(2j+1)
+  size_t table_size = size_t(1) << (k - 1);
+  std::vector<uint64_t> table(table_size * n);
+  memcpy(table.data(), gp, n * sizeof(uint64_t));
+  if (table_size > 1) {
+    std::vector<uint64_t> g2(n);
+    mul(g2.data(), gp, gp);
+    for (size_t j = 1; j < table_size; ++j) {
+      mul(table.data() + j * n, table.data() + (j - 1) * n, g2.data());
+    }
+  }
+
+  bool started = false;
+  size_t i = bits;
+  while (i > 0) {
+    if (!exp_bit(ep, i - 1)) {
+      if (started) {
+        mul(rp, rp, rp);
+      }
+      --i;
+      continue;
+    }
+
+    // the window is bits [low, i) of the exponent
+    size_t low = i >= k ? i - k : 0;
+    while (!exp_bit(ep, low)) {
+      ++low;
+    }
+    size_t value = 0;
+    for (size_t b = i; b > low; --b) {
+      value = (value << 1) | exp_bit(ep, b - 1);
+    }
+
+    const uint64_t *power = table.data() + (value >> 1) * n;
+    if (started) {
+      for (size_t b = low; b < i; ++b) {
+        mul(rp, rp, rp);
+      }
+      mul(rp, rp, power);
+    } else {
+      memcpy(rp, power, n * sizeof(uint64_t));
+      started = true;
+    }
+    i = low;
+  }
+}
+
+void limbs_powm(uint64_t *rp, const uint64_t *bp, size_t bn, const uint64_t *ep, size_t en,
+                const uint64_t *mp, size_t n)
+{
+  memset(rp, 0, n * sizeof(uint64_t));
+  if (n == 1 && mp[0] == 1) {
+    return;
+  }
+  en = limbs_normalized_size(ep, en);
+  if (en == 0) {
+    rp[0] = 1;
+    return;
+  }
+
+  if (mp[0] & 1) {
+    // Montgomery form: x is represented by x*R mod m, R = 2^(64n), so
+    // the base is converted with one division and the result with one
+    // reduction
+    uint64_t minv = limbs_mont_inverse(mp[0]);
+    std::vector<uint64_t> shifted(n + bn, 0), base(n);
+    memcpy(shifted.data() + n, bp, bn * sizeof(uint64_t));
+    limbs_div_qr(nullptr, base.data(), shifted.data(), n + bn, mp, n);
+
+    std::vector<uint64_t> scratch(limbs_mont_mul_scratch_size(n));
+    pow_sliding_window(rp, base.data(), ep, en, n, [&](uint64_t *r, const uint64_t *a, const uint64_t *b) {
+      limbs_mont_mul(r, a, b, mp, n, minv, scratch.data());
+    });
+
+    std::vector<uint64_t> t(2 * n, 0);
+    memcpy(t.data(), rp, n * sizeof(uint64_t));
+    limbs_redc(rp, t.data(), mp, n, minv);
+  } else {
+    // Montgomery reduction needs an odd modulus; reduce each product
+    // by division instead
+    std::vector<uint64_t> base(n, 0);
+    if (bn >= n) {
+      limbs_div_qr(nullptr, base.data(), bp, bn, mp, n);
+    } else {
+      memcpy(base.data(), bp, bn * sizeof(uint64_t));
+    }
+
+    std::vector<uint64_t> product(2 * n), scratch(limbs_mul_n_scratch_size(n));
+    pow_sliding_window(rp, base.data(), ep, en, n, [&](uint64_t *r, const uint64_t *a, const uint64_t *b) {
+      limbs_mul_n(product.data(), a, b, n, scratch.data());
+      limbs_div_qr(nullptr, r, product.data(), 2 * n, mp, n);
+    });
+  }
+}
+
+BigIntModContext::BigIntModContext(const BigInt &modulus)
+  : mod(modulus)
+{
+  if (mod.negative || mod.is_zero()) {
+    throw std::invalid_argument("modulus must be positive");
+  }
+  size_t n = mod.nums.size();
+  shift = __builtin_clzll(mod.nums.back());
+  normalized.resize(n);
+  if (shift != 0) {
+    limbs_lshift(normalized.data(), mod.nums.data(), n, shift);
+  } else {
+    memcpy(normalized.data(), mod.nums.data(), n * sizeof(uint64_t));
+  }
+  dinv = limbs_invert_limb(normalized.back());
+
+  if (n >= mod_barrett_threshold) {
+    std::vector<uint64_t> power(2 * n + 1, 0), quotient(n + 2), remainder(n);
+    power[2 * n] = 1;
+    limbs_div_qr(quotient.data(), remainder.data(), power.data(), 2 * n + 1, mod.nums.data(), n);
+    quotient.resize(limbs_normalized_size(quotient.data(), n + 2));
+    mu = std::move(quotient);
+  }
+}
+
+void BigIntModContext::barrett_reduce(BigInt &res, const uint64_t *xp, size_t xn) const
+{
+  // With B = 2^64, the estimate
+  //   q = floor(floor(x / B^(n-1)) * mu / B^(n+1))
+  // is at most 2 below floor(x / mod) (Handbook of Applied
+  // Cryptography, 14.42), so x - q * mod < 3 * mod < B^(n+1), and it
+  // can be computed modulo B^(n+1).
+  const uint64_t *mp = mod.nums.data();
+  size_t n = mod.nums.size();
+  const uint64_t *hp = xp + n - 1;
+  size_t hn = xn - (n - 1);
+  LimbVector t;
+  t.resize(hn + mu.size());
+  if (hn >= mu.size()) {
+    limbs_mul(t.data(), hp, hn, mu.data(), mu.size());
+  } else {
+    limbs_mul(t.data(), mu.data(), mu.size(), hp, hn);
+  }
+  const uint64_t *qp = t.data() + n + 1;
+  size_t qn = limbs_normalized_size(qp, t.size() - (n + 1));
+
+  res.nums.resize(n + 1);
+  uint64_t *rp = res.nums.data();
+  size_t low = xn < n + 1 ? xn : n + 1;
+  memcpy(rp, xp, low * sizeof(uint64_t));
+  for (size_t i = low; i <= n; ++i) {
+    rp[i] = 0;
+  }
+  if (qn != 0) {
+    LimbVector qm;
+    qm.resize(qn + n);
+    if (qn >= n) {
+      limbs_mul(qm.data(), qp, qn, mp, n);
+    } else {
+      limbs_mul(qm.data(), mp, n, qp, qn);
+    }
+    limbs_sub(rp, rp, n + 1, qm.data(), qn + n < n + 1 ? qn + n : n + 1);
+  }
+  while (rp[n] != 0 || limbs_cmp(rp, mp, n) >= 0) {
+    rp[n] -= limbs_sub_n(rp, rp, mp, n);
+  }
+  res.normalize();
+}
+
+void BigIntModContext::reduce_limbs(BigInt &res, const uint64_t *xp, size_t xn) const
+{
+  size_t n = mod.nums.size();
+  if (xn < n || (xn == n && limbs_cmp(xp, mod.nums.data(), n) < 0)) {
+    res.nums.resize(xn);
+    memcpy(res.nums.data(), xp, xn * sizeof(uint64_t));
+    res.normalize();
+    return;
+  }
+
+  if (!mu.empty() && xn <= 2 * n) {
+    barrett_reduce(res, xp, xn);
+    return;
+  }
+
+  res.nums.resize(n);
+  if (n >= div_bz_threshold && xn - n + 1 >= div_bz_threshold) {
+    // long enough for recursive division to win
+    limbs_div_qr(nullptr, res.nums.data(), xp, xn, mod.nums.data(), n);
+  } else {
+    LimbVector u;
+    u.resize(xn + 1);
+    if (shift != 0) {
+      u[xn] = limbs_lshift(u.data(), xp, xn, shift);
+    } else {
+      memcpy(u.data(), xp, xn * sizeof(uint64_t));
+      u[xn] = 0;
+    }
+    limbs_mod_preinv(u.data(), xn + 1, normalized.data(), n, dinv);
+    if (shift != 0) {
+      limbs_rshift(res.nums.data(), u.data(), n, shift);
+    } else {
+      memcpy(res.nums.data(), u.data(), n * sizeof(uint64_t));
+    }
+  }
+  res.normalize();
+}
+
+BigInt BigIntModContext::reduce(const BigInt &x) const
+{
+  BigInt res;
+  reduce_limbs(res, x.nums.data(), x.nums.size());
+  if (x.negative && !res.is_zero()) {
+    size_t n = mod.nums.size();
+    res.nums.resize(n);
+    limbs_sub(res.nums.data(), mod.nums.data(), n, res.nums.data(), n);
+    res.normalize();
+  }
+  return res;
+}
+
+const BigInt &BigIntModContext::reduced(const BigInt &x, BigInt &storage) const
+{
+  if (!x.negative && x.compare_magnitudes(mod) < 0) {
+    return x;
+  }
+  storage = reduce(x);
+  return storage;
+}
+
+BigInt BigIntModContext::mulmod(const BigInt &a, const BigInt &b) const
+{
+  BigInt a_storage, b_storage;
+  const BigInt &ra = reduced(a, a_storage);
+  const BigInt &rb = reduced(b, b_storage);
+  const BigInt &big = ra.nums.size() >= rb.nums.size() ? ra : rb;
+  const BigInt &small = ra.nums.size() >= rb.nums.size() ? rb : ra;
+
+  LimbVector product;
+  product.resize(big.nums.size() + small.nums.size());
+  limbs_mul(product.data(), big.nums.data(), big.nums.size(), small.nums.data(), small.nums.size());
+  BigInt res;
+  reduce_limbs(res, product.data(), product.size());
+  return res;
+}
+
+BigInt BigIntModContext::addmod(const BigInt &a, const BigInt &b) const
+{
+  BigInt a_storage, b_storage;
+  BigInt res = reduced(a, a_storage);
+  res += reduced(b, b_storage);
+  if (res >= mod) {
+    res -= mod;
+  }
+  return res;
+}
+
+BigInt BigIntModContext::submod(const BigInt &a, const BigInt &b) const
+{
+  BigInt a_storage, b_storage;
+  BigInt res = reduced(a, a_storage);
+  res -= reduced(b, b_storage);
+  if (res.negative) {
+    res += mod;
+  }
+  return res;
+}
@@ -0,0 +1,85 @@
+#ifndef BIGINT_MOD_H
+#define BIGINT_MOD_H
+
+#include <cstdint>
+#include <vector>
+#include "bigint.h"
+
+//! @file
+//! Modular arithmetic with a fixed modulus.
+
+//! Arithmetic modulo a fixed positive modulus. Building a context does
+//! the setup of a reduction once, so that each reduction by the same
+//! modulus costs less than a division. For a modulus of fewer than
+//! `mod_barrett_threshold` limbs, the context normalizes the modulus
+//! and computes a reciprocal of its top limb, so that reductions skip
+//! the setup of a general division and estimate each quotient digit
+//! with a multiplication rather than a hardware division. For longer
+//! moduli, it also computes the Barrett reciprocal
+//! `floor(2^(128n) / modulus)` (n the limb count of the modulus),
+//! with which a value of up to 2n limbs (e.g., a product in `mulmod`)
+//! is reduced by two multiplications, using the fast multiplication
+//! algorithms, and at most two subtractions.
+//! All results are in the range `[0, modulus)`. Operands may be any
+//! BigInt values (including negative ones), but operands already in
+//! that range are handled fastest. A context is not modified by its
+//! operations, so it can be shared between threads.
+class BigIntModContext {
+private:
+  BigInt mod;
+  unsigned shift;                  // normalizing shift of the modulus
+  std::vector<uint64_t> normalized; // mod << shift (top bit set)
+  uint64_t dinv;                   // limbs_invert_limb(top limb of normalized)
+  std::vector<uint64_t> mu;        // floor(2^(128n) / mod), if n >= mod_barrett_threshold
+
+  // Store xp[0..xn) mod the modulus in res, for n <= xn <= 2n, by
+  // Barrett reduction.
+  void barrett_reduce(BigInt &res, const uint64_t *xp, size_t xn) const;
+
+  // Store xp[0..xn) mod the modulus in res.
+  void reduce_limbs(BigInt &res, const uint64_t *xp, size_t xn) const;
+
+  // Return the residue of x in [0, mod), storing it in storage if x
+  // is not already in that range.
+  const BigInt &reduced(const BigInt &x, BigInt &storage) const;
+
+public:
+  //! Constructor.
+  //!
+  //! @param modulus the modulus, which must be positive
+  //! @throw std::invalid_argument if `modulus` is not positive
+  explicit BigIntModContext(const BigInt &modulus);
+
+  //! Return the modulus.
+  const BigInt &modulus() const { return mod; }
+
+  //! Reduce a value modulo the modulus. Unlike `%`, the result is never
+  //! negative.
+  //!
+  //! @param x the value to reduce
+  //! @return `x mod modulus`, in the range `[0, modulus)`
+  BigInt reduce(const BigInt &x) const;
+
+  //! Modular multiplication.
+  //!
+  //! @param a the left-hand operand
+  //! @param b the right-hand operand
+  //! @return `a * b mod modulus`
+  BigInt mulmod(const BigInt &a, const BigInt &b) const;
+
+  //! Modular addition.
+  //!
+  //! @param a the left-hand operand
+  //! @param b the right-hand operand
+  //! @return `a + b mod modulus`
+  BigInt addmod(const BigInt &a, const BigInt &b) const;
+
+  //! Modular subtraction.
+  //!
+  //! @param a the left-hand operand
+  //! @param b the right-hand operand
+  //! @return `a - b mod modulus`
+  BigInt submod(const BigInt &a, const BigInt &b) const;
+};
+
+#endif // BIGINT_MOD_H
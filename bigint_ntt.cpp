@@ -0,0 +1,228 @@
+#include <vector>
+#include "bigint_limbs.h"
+
+//! @file
+//! Multiplication by number-theoretic transform. Each operand limb is
+//! used directly as a transform coefficient; the cyclic convolution is
+//! computed modulo three 62-bit primes of the form c*2^40 + 1 and the
+//! exact coefficients (up to ~2^150) are recovered by the Chinese
+//! remainder theorem before carries are propagated. Transform lengths
+//! up to 2^40 are supported, far beyond any practical operand size.
+
+typedef unsigned __int128 uint128_t;
+
+namespace {
+
+// Arithmetic modulo a prime p < 2^62, with multiplication done in
+// Montgomery form (R = 2^64). Values passed around are kept in
+// [0, p); constants that are multiplied in are stored pre-scaled by R
+// so that mul(x, c*R) yields x*c mod p.
+struct NttPrime {
+  uint64_t p;
+  uint64_t neg_pinv;   // -p^-1 mod 2^64
+  uint64_t r1;         // R mod p (i.e., 1 in Montgomery form)
+  uint64_t r2;         // R^2 mod p
+  uint64_t generator;  // primitive root mod p
+
+  NttPrime(uint64_t prime, uint64_t g)
+    : p(prime), generator(g)
+  {
+    uint64_t inv = p; // correct to 3 bits; each step doubles that
+    for (int i = 0; i < 5; ++i) {
+      inv *= 2 - p * inv;
+    }
+    neg_pinv = -inv;
+    r1 = (uint64_t) (((uint128_t) 1 << 64) % p);
+    r2 = (uint64_t) (((uint128_t) r1 * r1) % p);
+  }
+
+  uint64_t reduce(uint128_t t) const
+  {
+    uint64_t m = (uint64_t) t * neg_pinv;
+    uint64_t res = (uint64_t) ((t + (uint128_t) m * p) >> 64);
+    return res >= p ? res - p : res;
+  }
+
+  uint64_t mul(uint64_t a, uint64_t b) const { return reduce((uint128_t) a * b); }
+  // reduce a full limb; p > 2^61, so at most a few subtractions
+  uint64_t from_limb(uint64_t a) const
+  {
+    while (a >= p) {
+      a -= p;
+    }
+    return a;
+  }
+
+  uint64_t add(uint64_t a, uint64_t b) const { uint64_t s = a + b; return s >= p ? s - p : s; }
+  uint64_t sub(uint64_t a, uint64_t b) const { return a >= b ? a - b : a + p - b; }
+
+  // convert a plain residue into Montgomery form
+  uint64_t to_mont(uint64_t a) const { return mul(a, r2); }
+
+  // a^e mod p, with a and the result in Montgomery form
+  uint64_t pow(uint64_t a, uint64_t e) const
+  {
+    uint64_t res = r1;
+    while (e != 0) {
+      if (e & 1) {
+        res = mul(res, a);
+      }
+      a = mul(a, a);
+      e >>= 1;
+    }
+    return res;
+  }
+
+  // a^-1 mod p, in Montgomery form
+  uint64_t inverse(uint64_t a) const { return pow(a, p - 2); }
+};
+
+const NttPrime &ntt_prime(int i)
+{
+  static const NttPrime primes[3] = {
+    NttPrime(0x3fffc00000000001UL, 11),
+    NttPrime(0x3fffbe0000000001UL, 3),
+    NttPrime(0x3fff840000000001UL, 19),
+  };
+  return primes[i];
+}
+
+// Fill roots[h + j] (1 <= h < len, 0 <= j < h, h a power of two) with
+// w^j in Montgomery form, where w is a primitive (2h)-th root of unity,
+// or its inverse when `inverse` is set.
+void ntt_roots(const NttPrime &f, std::vector<uint64_t> &roots, size_t len, bool inverse)
+{
+  roots.resize(len);
+  uint64_t g = f.to_mont(f.generator);
+  for (size_t h = 1; h < len; h <<= 1) {
+    uint64_t w = f.pow(g, (f.p - 1) / (2 * h));
+    if (inverse) {
+      w = f.inverse(w);
+    }
+    uint64_t cur = f.r1;
+    for (size_t j = 0; j < h; ++j) {
+      roots[h + j] = cur;
+      cur = f.mul(cur, w);
+    }
+  }
+}
+
+// Decimation-in-frequency transform; output is in bit-reversed order.
+void ntt_forward(const NttPrime &f, uint64_t *a, size_t len, const std::vector<uint64_t> &roots)
+{
+  for (size_t h = len / 2; h >= 1; h >>= 1) {
+    for (size_t s = 0; s < len; s += 2 * h) {
+      for (size_t j = 0; j < h; ++j) {
+        uint64_t u = a[s + j];
+        uint64_t v = a[s + j + h];
+        a[s + j] = f.add(u, v);
+        a[s + j + h] = f.mul(f.sub(u, v), roots[h + j]);
+      }
+    }
+  }
+}
+
+// Decimation-in-time inverse transform; input is in bit-reversed order,
+// output in natural order, without the 1/len scaling.
+void ntt_inverse(const NttPrime &f, uint64_t *a, size_t len, const std::vector<uint64_t> &roots)
+{
+  for (size_t h = 1; h < len; h <<= 1) {
+    for (size_t s = 0; s < len; s += 2 * h) {
+      for (size_t j = 0; j < h; ++j) {
+        uint64_t u = a[s + j];
+        uint64_t v = f.mul(a[s + j + h], roots[h + j]);
+        a[s + j] = f.add(u, v);
+        a[s + j + h] = f.sub(u, v);
+      }
+    }
+  }
+}
+
+// Cyclic convolution of a and b (zero-padded to len) modulo one prime.
+void ntt_convolve(const NttPrime &f, uint64_t *out, uint64_t *tmp,
+                  const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn, size_t len)
+{
+  // a square needs only one forward transform
+  bool square = ap == bp && an == bn;
+  for (size_t i = 0; i < len; ++i) {
+    out[i] = i < an ? f.from_limb(ap[i]) : 0;
+    if (!square) {
+      tmp[i] = i < bn ? f.from_limb(bp[i]) : 0;
+    }
+  }
+
+  std::vector<uint64_t> roots;
+  ntt_roots(f, roots, len, false);
+  ntt_forward(f, out, len, roots);
+  if (!square) {
+    ntt_forward(f, tmp, len, roots);
+  }
+  const uint64_t *other = square ? out : tmp;
+
+  // mul() leaves a factor of R^-1 on the pointwise product; multiplying
+  // by (R^2/len) in the same pass cancels it and applies the scaling
+  uint64_t scale = f.mul(f.inverse(f.to_mont(len)), f.r2);
+  for (size_t i = 0; i < len; ++i) {
+    out[i] = f.mul(f.mul(out[i], other[i]), scale);
+  }
+
+  ntt_roots(f, roots, len, true);
+  ntt_inverse(f, out, len, roots);
+}
+
+}
+
+// Timed against Toom-3: the NTT wins from ~25000 limbs (its cost steps
+// up at each power-of-two transform length, so the crossover is fuzzy).
+size_t mul_ntt_threshold = 25000;
+
+void limbs_mul_ntt(uint64_t *rp, const uint64_t *ap, size_t an, const uint64_t *bp, size_t bn)
+{
+  size_t coeffs = an + bn - 1;
+  size_t len = 1;
+  while (len < coeffs) {
+    len <<= 1;
+  }
+
+  const NttPrime &f0 = ntt_prime(0), &f1 = ntt_prime(1), &f2 = ntt_prime(2);
+  std::vector<uint64_t> c0(len), c1(len), c2(len), tmp(len);
+  ntt_convolve(f0, c0.data(), tmp.data(), ap, an, bp, bn, len);
+  ntt_convolve(f1, c1.data(), tmp.data(), ap, an, bp, bn, len);
+  ntt_convolve(f2, c2.data(), tmp.data(), ap, an, bp, bn, len);
+
+  // Garner's algorithm: x = x0 + p0*y1 + p0*p1*y2 with
+  //   y1 = (x1 - x0) / p0             (mod p1)
+  //   y2 = (x2 - x0 - p0*y1) / (p0*p1)  (mod p2)
+  uint64_t p0 = f0.p;
+  uint64_t inv_p0_mod_p1 = f1.inverse(f1.to_mont(p0 % f1.p));
+  uint64_t p0_mod_p2 = f2.to_mont(p0 % f2.p);
+  uint64_t inv_p0p1_mod_p2 = f2.inverse(f2.mul(f2.to_mont(p0 % f2.p), f2.to_mont(f1.p % f2.p)));
+  uint128_t p0p1 = (uint128_t) p0 * f1.p;
+  uint64_t p0p1_lo = (uint64_t) p0p1, p0p1_hi = (uint64_t) (p0p1 >> 64);
+
+  uint64_t carry[3] = { 0, 0, 0 };
+  for (size_t i = 0; i < coeffs; ++i) {
+    uint64_t x0 = c0[i];
+    uint64_t y1 = f1.mul(f1.sub(c1[i], f1.from_limb(x0)), inv_p0_mod_p1);
+    uint64_t t = f2.sub(c2[i], f2.from_limb(x0));
+    t = f2.sub(t, f2.mul(y1, p0_mod_p2));
+    uint64_t y2 = f2.mul(t, inv_p0p1_mod_p2);
+
+    // x = x0 + p0*y1 + p0p1*y2, as three limbs
+    uint128_t lo = (uint128_t) p0 * y1 + x0;
+    uint128_t mid = (uint128_t) p0p1_lo * y2;
+    uint128_t hi = (uint128_t) p0p1_hi * y2;
+    uint128_t acc = (uint128_t) (uint64_t) lo + (uint64_t) mid + carry[0];
+    uint64_t x_0 = (uint64_t) acc;
+    acc = (acc >> 64) + (uint64_t) (lo >> 64) + (uint64_t) (mid >> 64) + (uint64_t) hi + carry[1];
+    uint64_t x_1 = (uint64_t) acc;
+    acc = (acc >> 64) + (uint64_t) (hi >> 64) + carry[2];
+
+    rp[i] = x_0;
+    carry[0] = x_1;
+    carry[1] = (uint64_t) acc;
+    carry[2] = (uint64_t) (acc >> 64);
+  }
+  // the remaining carry fits in the top limb of the product
+  rp[coeffs] = carry[0];
+}
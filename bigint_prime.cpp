@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "bigint.h"
+#include "bigint_limbs.h"
+#include "bigint_mod.h"
+
+//! @file
+//! Probable prime testing (trial division followed by the Baillie-PSW
+//! test) and prime search by sieving windows of candidates.
+
+namespace {
+
+// The odd primes below this bound are tried by trial division (and
+// used to sieve in next_prime); smaller values than its square are
+// decided by trial division alone.
+const uint64_t TRIAL_BOUND = 4096;
+
+// The odd primes below TRIAL_BOUND, in groups whose products fit in a
+// limb: one remainder by a group's product, from limbs_mod_1, gives
+// the remainders by all of its primes with 64-bit arithmetic.
+struct SmallPrimes {
+  std::vector<uint64_t> primes;
+  std::vector<uint64_t> products;
+  std::vector<size_t> ends;       // end of each group in primes
+};
+
+const SmallPrimes &small_primes()
+{
+  static const SmallPrimes table = [] {
+    SmallPrimes t;
+    std::vector<bool> composite(TRIAL_BOUND);
+    for (uint64_t p = 3; p < TRIAL_BOUND; p += 2) {
+      if (composite[p]) {
+        continue;
+      }
+      for (uint64_t j = p * p; j < TRIAL_BOUND; j += 2 * p) {
+        composite[j] = true;
+      }
+      if (t.products.empty() || t.products.back() > UINT64_MAX / p) {
+        if (!t.products.empty()) {
+          t.ends.push_back(t.primes.size());
+        }
+        t.products.push_back(p);
+      } else {
+        t.products.back() *= p;
+      }
+      t.primes.push_back(p);
+    }
+    t.ends.push_back(t.primes.size());
+    return t;
+  }();
+  return table;
+}
+
+// Jacobi symbol (a/n) for odd n.
+int jacobi(uint64_t a, uint64_t n)
+{
+  int result = 1;
+  a %= n;
+  while (a != 0) {
+    unsigned twos = __builtin_ctzll(a);
+    a >>= twos;
+    if ((twos & 1) && (n % 8 == 3 || n % 8 == 5)) {
+      result = -result;
+    }
+    if (a % 4 == 3 && n % 4 == 3) {
+      result = -result;
+    }
+    std::swap(a, n);
+    a %= n;
+  }
+  return n == 1 ? result : 0;
+}
+
+// Jacobi symbol (d/n) for a small odd d and a multi-limb odd n, by
+// reciprocity: (d/n) = (n mod |d| / |d|), up to the signs given by
+// n and |d| mod 4.
+int jacobi(int64_t d, const BigInt &n)
+{
+  LimbSpan limbs = n.get_bit_vector();
+  uint64_t abs_d = d < 0 ? -(uint64_t) d : d;
+  int result = jacobi(limbs_mod_1(limbs.data(), limbs.size(), abs_d), abs_d);
+  if (abs_d % 4 == 3 && limbs[0] % 4 == 3) {
+    result = -result;
+  }
+  if (d < 0 && limbs[0] % 4 == 3) {
+    result = -result; // (-1/n)
+  }
+  return result;
+}
+
+unsigned trailing_zeros(const BigInt &x)
+{
+  LimbSpan limbs = x.get_bit_vector();
+  size_t i = 0;
+  while (limbs[i] == 0) {
+    ++i;
+  }
+  return 64 * i + __builtin_ctzll(limbs[i]);
+}
+
+// Strong probable prime test to the given base: with n - 1 = d * 2^s,
+// d odd, either base^d = 1 or base^(d*2^r) = -1 for some r < s.
+bool strong_probable_prime(const BigInt &n, const BigIntModContext &ctx, const BigInt &base)
+{
+  BigInt n_minus_1 = n - BigInt(1);
+  unsigned s = trailing_zeros(n_minus_1);
+  BigInt x = base.modpow(n_minus_1 >> s, n);
+  if (x == BigInt(1) || x == n_minus_1) {
+    return true;
+  }
+  for (unsigned r = 1; r < s; ++r) {
+    x = ctx.mulmod(x, x);
+    if (x == n_minus_1) {
+      return true;
+    }
+    if (x == BigInt(1)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Arithmetic on residues modulo an odd n in Montgomery form (x R mod n,
+// R = 2^(64 * limbs)), so that products need no division. Zero, sums,
+// differences and halves carry over unchanged from the plain residues.
+class MontgomeryResidues {
+private:
+  const uint64_t *mp;
+  size_t n;
+  uint64_t minv;
+  std::vector<uint64_t> scratch;
+
+public:
+  explicit MontgomeryResidues(const BigInt &modulus)
+    : mp(modulus.get_bit_vector().data()), n(modulus.get_bit_vector().size()),
+      minv(limbs_mont_inverse(mp[0])), scratch(limbs_mont_mul_scratch_size(n)) { }
+
+  size_t size() const { return n; }
+
+  // rp = x R mod n for a small signed x
+  void set(uint64_t *rp, int64_t x) const
+  {
+    std::vector<uint64_t> t(n + 1);
+    t[n] = x < 0 ? -(uint64_t) x : x;
+    limbs_div_qr(nullptr, rp, t.data(), n + 1, mp, n);
+    if (x < 0 && limbs_normalized_size(rp, n) != 0) {
+      limbs_sub_n(rp, mp, rp, n);
+    }
+  }
+
+  void mul(uint64_t *rp, const uint64_t *ap, const uint64_t *bp)
+  {
+    limbs_mont_mul(rp, ap, bp, mp, n, minv, scratch.data());
+  }
+
+  void add(uint64_t *rp, const uint64_t *ap, const uint64_t *bp) const
+  {
+    if (limbs_add_n(rp, ap, bp, n) || limbs_cmp(rp, mp, n) >= 0) {
+      limbs_sub_n(rp, rp, mp, n);
+    }
+  }
+
+  void sub(uint64_t *rp, const uint64_t *ap, const uint64_t *bp) const
+  {
+    if (limbs_sub_n(rp, ap, bp, n)) {
+      limbs_add_n(rp, rp, mp, n);
+    }
+  }
+
+  // rp = ap / 2 mod n
+  void half(uint64_t *rp, const uint64_t *ap) const
+  {
+    uint64_t carry = 0;
+    if (ap[0] & 1) {
+      carry = limbs_add_n(rp, ap, mp, n);
+      ap = rp;
+    }
+    limbs_rshift(rp, ap, n, 1);
+    rp[n - 1] |= carry << 63;
+  }
+};
+
+// Strong Lucas probable prime test with Selfridge's parameters: D is
+// the first of 5, -7, 9, -11, ... with (D/n) = -1, P = 1 and
+// Q = (1 - D)/4. With n + 1 = d * 2^s, d odd, either U_d = 0 or
+// V_(d*2^r) = 0 for some r < s (mod n).
+bool strong_lucas_probable_prime(const BigInt &n)
+{
+  int64_t d = 5;
+  for (int tries = 0;; ++tries) {
+    int j = jacobi(d, n);
+    if (j == -1) {
+      break;
+    }
+    if (j == 0) {
+      return false; // |d| < n shares a factor with n
+    }
+    // no such D exists for a square, so check for one once the search
+    // takes longer than usual
+    if (tries == 16 && n.is_perfect_square()) {
+      return false;
+    }
+    d = d > 0 ? -(d + 2) : -d + 2;
+  }
+
+  // The sequence runs in Montgomery form: it takes about three
+  // products per bit of n, and these dominate the test.
+  MontgomeryResidues mont(n);
+  size_t size = mont.size();
+  std::vector<uint64_t> storage(6 * size);
+  uint64_t *u = storage.data(), *v = u + size, *qk = v + size;
+  uint64_t *q = qk + size, *big_d = q + size, *t = big_d + size;
+  mont.set(big_d, d);
+  mont.set(q, (1 - d) / 4);
+  mont.set(u, 1);
+  mont.set(v, 1);
+  std::copy(q, q + size, qk);
+
+  // U_k, V_k and Q^k, from k = 1 over the bits of d: doubling uses
+  //   U_2k = U_k V_k,  V_2k = V_k^2 - 2 Q^k
+  // and adding one
+  //   U_(k+1) = (U_k + V_k)/2,  V_(k+1) = (D U_k + V_k)/2
+  BigInt n_plus_1 = n + BigInt(1);
+  unsigned s = trailing_zeros(n_plus_1);
+  BigInt k = n_plus_1 >> s;
+  LimbSpan bits = k.get_bit_vector();
+  size_t top = 64 * bits.size() - __builtin_clzll(bits.back()) - 1;
+  for (size_t bit = top; bit > 0; --bit) {
+    mont.mul(u, u, v);
+    mont.mul(v, v, v);
+    mont.add(t, qk, qk);
+    mont.sub(v, v, t);
+    mont.mul(qk, qk, qk);
+    if (k.is_bit_set(bit - 1)) {
+      mont.mul(t, big_d, u);
+      mont.add(u, u, v);
+      mont.half(u, u);
+      mont.add(v, t, v);
+      mont.half(v, v);
+      mont.mul(qk, qk, q);
+    }
+  }
+
+  if (limbs_normalized_size(u, size) == 0 || limbs_normalized_size(v, size) == 0) {
+    return true;
+  }
+  for (unsigned r = 1; r < s; ++r) {
+    mont.mul(v, v, v);
+    mont.add(t, qk, qk);
+    mont.sub(v, v, t);
+    if (limbs_normalized_size(v, size) == 0) {
+      return true;
+    }
+    mont.mul(qk, qk, qk);
+  }
+  return false;
+}
+
+// The Baillie-PSW test, for odd n without factors below TRIAL_BOUND:
+// a strong probable prime test to base 2 and a strong Lucas test. No
+// composite is known to pass both.
+bool baillie_psw(const BigInt &n)
+{
+  BigIntModContext ctx(n);
+  return strong_probable_prime(n, ctx, BigInt(2)) && strong_lucas_probable_prime(n);
+}
+
+}
+
+bool BigInt::is_probable_prime(unsigned rounds) const
+{
+  if (negative || (nums.size() == 1 && nums[0] < 4)) {
+    return !negative && nums[0] >= 2;
+  }
+  if (!(nums[0] & 1)) {
+    return false;
+  }
+
+  const SmallPrimes &sp = small_primes();
+  bool small = nums.size() == 1 && nums[0] < TRIAL_BOUND * TRIAL_BOUND;
+  size_t begin = 0;
+  for (size_t g = 0; g < sp.products.size(); ++g) {
+    uint64_t r = limbs_mod_1(nums.data(), nums.size(), sp.products[g]);
+    for (size_t i = begin; i < sp.ends[g]; ++i) {
+      if (r % sp.primes[i] == 0) {
+        return small && nums[0] == sp.primes[i];
+      }
+    }
+    begin = sp.ends[g];
+  }
+  if (small) {
+    return true;
+  }
+
+  if (!baillie_psw(*this)) {
+    return false;
+  }
+
+  // extra rounds with pseudo-random bases in [2, n-2]; the generator
+  // is seeded from the value, so that the answer is reproducible
+  if (rounds > 0) {
+    BigIntModContext ctx(*this);
+    std::mt19937_64 rng(nums[0] ^ nums.size());
+    BigInt range = *this - BigInt(3);
+    for (unsigned i = 0; i < rounds; ++i) {
+      BigInt base;
+      base.nums.resize(nums.size());
+      for (uint64_t &limb : base.nums) {
+        limb = rng();
+      }
+      base.normalize();
+      base = base % range + BigInt(2);
+      if (!strong_probable_prime(*this, ctx, base)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+BigInt BigInt::next_prime() const
+{
+  if (negative || compare(BigInt(2)) < 0) {
+    return BigInt(2);
+  }
+
+  BigInt start = *this + BigInt(1);
+  if (!start.is_bit_set(0)) {
+    start += BigInt(1);
+  }
+
+  // Sieve the odd candidates start + 2i, i < window, by the small
+  // primes, and run the full test only on the survivors. Prime gaps
+  // average ln(x), about 0.7 bits, so a window of as many candidates
+  // as bits usually holds the next prime.
+  const SmallPrimes &sp = small_primes();
+  size_t window = std::max((size_t) 256, 64 * start.nums.size());
+  std::vector<bool> composite(window);
+  while (true) {
+    std::fill(composite.begin(), composite.end(), false);
+    size_t begin = 0;
+    for (size_t g = 0; g < sp.products.size(); ++g) {
+      uint64_t r = limbs_mod_1(start.nums.data(), start.nums.size(), sp.products[g]);
+      for (size_t j = begin; j < sp.ends[g]; ++j) {
+        uint64_t p = sp.primes[j];
+        // start + 2i = 0 (mod p) for i = -start/2 (mod p)
+        uint64_t i = (p - r % p) % p;
+        i = (i & 1) ? (i + p) / 2 : i / 2;
+        if (start.nums.size() == 1 && start.nums[0] <= p && p - start.nums[0] == 2 * i) {
+          i += p; // p itself is prime
+        }
+        for (; i < window; i += p) {
+          composite[i] = true;
+        }
+      }
+      begin = sp.ends[g];
+    }
+
+    for (size_t i = 0; i < window; ++i) {
+      if (composite[i]) {
+        continue;
+      }
+      BigInt candidate = start + BigInt(2 * i);
+      bool small = candidate.nums.size() == 1 && candidate.nums[0] < TRIAL_BOUND * TRIAL_BOUND;
+      if (small || baillie_psw(candidate)) {
+        return candidate;
+      }
+    }
+    start += BigInt(2 * window);
+  }
+}
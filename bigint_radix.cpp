@@ -0,0 +1,281 @@
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include "bigint_limbs.h"
+
+//! @file
+//! Conversion between limb arrays and decimal strings. Both directions
+//! work on 19-digit chunks (10^19 is the largest power of ten that
+//! fits in a limb) and, for long values, split recursively by the
+//! cached powers 10^(19*2^k) so that the work is dominated by a few
+//! large divisions or multiplications.
+
+static const uint64_t POW10_19 = 10000000000000000000UL;
+static const size_t DIGITS_PER_LIMB = 19;
+
+// Chosen by timing to_dec on a ~400-limb value with thresholds from 2
+// to 80 limbs; anything from 20 to 80 is within 10% of the best.
+size_t to_dec_dc_threshold = 50;
+
+// Chosen by timing from_dec on 100k-digit strings: 5-10 chunks is
+// best, and ~2.5x faster than plain Horner's rule at that length.
+size_t from_dec_dc_threshold = 10;
+
+const std::vector<uint64_t> &limbs_pow10_cached(unsigned k)
+{
+  // a deque, so that growing the cache never moves existing entries
+  static std::deque<std::vector<uint64_t>> cache;
+  static std::mutex lock;
+
+  std::lock_guard<std::mutex> guard(lock);
+  if (cache.empty()) {
+    cache.push_back(std::vector<uint64_t>(1, POW10_19));
+  }
+  while (cache.size() <= k) {
+    const std::vector<uint64_t> &prev = cache.back();
+    std::vector<uint64_t> sq(2 * prev.size());
+    limbs_mul(sq.data(), prev.data(), prev.size(), prev.data(), prev.size());
+    sq.resize(limbs_normalized_size(sq.data(), sq.size()));
+    cache.push_back(sq);
+  }
+  return cache[k];
+}
+
+// Append `chunk` (< 10^19) in decimal, left-padded with zeros to
+// `width` digits.
+static void append_chunk(std::string &out, uint64_t chunk, size_t width)
+{
+  char buf[DIGITS_PER_LIMB + 1];
+  size_t len = 0;
+  do {
+    buf[len++] = '0' + chunk % 10;
+    chunk /= 10;
+  } while (chunk != 0);
+  for (; len < width; ++len) {
+    buf[len] = '0';
+  }
+  while (len > 0) {
+    out.push_back(buf[--len]);
+  }
+}
+
+// Quadratic conversion for short values: repeatedly divide by 10^19.
+static void to_dec_basecase(std::string &out, const uint64_t *ap, size_t n, size_t width)
+{
+  std::vector<uint64_t> t(ap, ap + n);
+  std::vector<uint64_t> chunks;
+  while (n > 0) {
+    chunks.push_back(limbs_divrem_1(t.data(), t.data(), n, POW10_19));
+    n = limbs_normalized_size(t.data(), n);
+  }
+
+  size_t digits = 0;
+  if (!chunks.empty()) {
+    uint64_t top = chunks.back();
+    for (digits = 1; top >= 10; top /= 10) {
+      ++digits;
+    }
+    digits += DIGITS_PER_LIMB * (chunks.size() - 1);
+  }
+  for (; digits < width; ++digits) {
+    out.push_back('0');
+  }
+
+  for (size_t i = chunks.size(); i > 0; --i) {
+    append_chunk(out, chunks[i - 1], i == chunks.size() ? 0 : DIGITS_PER_LIMB);
+  }
+}
+
+// Append the digits of ap[0..n), left-padded with zeros to `width`
+// digits. The value is split as q * 10^(19*2^k) + r with the power
+// about half as long as the value, and both halves converted
+// recursively (r padded to exactly 19*2^k digits).
+static void to_dec_rec(std::string &out, const uint64_t *ap, size_t n, size_t width)
+{
+  n = limbs_normalized_size(ap, n);
+  if (n < to_dec_dc_threshold || n < 2) {
+    to_dec_basecase(out, ap, n, width);
+    return;
+  }
+
+  unsigned k = 0;
+  while (2 * limbs_pow10_cached(k + 1).size() <= n + 1) {
+    ++k;
+  }
+  const std::vector<uint64_t> &pow = limbs_pow10_cached(k);
+  size_t pn = pow.size();
+  size_t low_digits = DIGITS_PER_LIMB << k;
+
+  std::vector<uint64_t> q(n - pn + 1), r(pn);
+  limbs_div_qr(q.data(), r.data(), ap, n, pow.data(), pn);
+  to_dec_rec(out, q.data(), q.size(), width > low_digits ? width - low_digits : 0);
+  to_dec_rec(out, r.data(), r.size(), low_digits);
+}
+
+void limbs_to_dec(std::string &out, const uint64_t *ap, size_t n)
+{
+  if (limbs_normalized_size(ap, n) == 0) {
+    out.push_back('0');
+    return;
+  }
+  to_dec_rec(out, ap, n, 0);
+}
+
+// Check that the 8 bytes in `word` are all ASCII digits: a byte is a
+// digit iff adding 0x46 does not carry into bit 7 and subtracting 0x30
+// does not borrow from it.
+static bool swar_all_digits(uint64_t word)
+{
+  return (((word + 0x4646464646464646UL) | (word - 0x3030303030303030UL)) &
+          0x8080808080808080UL) == 0;
+}
+
+// Value of the 8 digits in `word` (first digit in the low byte, as
+// loaded from memory on a little-endian machine): adjacent digits are
+// combined into 2-digit, then 4-digit, then the 8-digit value, with
+// one multiply per step operating on all lanes at once.
+static uint64_t swar_parse8(uint64_t word)
+{
+  word -= 0x3030303030303030UL;
+  word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFUL;
+  word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFUL;
+  return (word * 10000 + (word >> 32)) & 0xFFFFFFFFUL;
+}
+
+// Parse n <= 19 digits into a value below 10^19. The leading n % 8
+// digits are handled one at a time, the rest 8 at a time (at most two
+// SWAR steps, since n <= 19).
+static bool parse_chunk(const char *p, size_t n, uint64_t *value)
+{
+  uint64_t v = 0;
+  size_t i = 0;
+  for (; i < n % 8; ++i) {
+    unsigned digit = (unsigned char) p[i] - '0';
+    if (digit > 9) {
+      return false;
+    }
+    v = v * 10 + digit;
+  }
+  for (; i < n; i += 8) {
+    uint64_t word;
+    memcpy(&word, p + i, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    if (!swar_all_digits(word)) {
+      return false;
+    }
+    v = v * 100000000 + swar_parse8(word);
+  }
+  *value = v;
+  return true;
+}
+
+// rp[0..m) = sum of c[i] * 10^(19*i) for i < m, where each c[i] is
+// below 10^19. Long chunk arrays are split at the largest power of two
+// below m, so that the high part is multiplied by a cached power of
+// ten and the pieces are combined with fast multiplication.
+static void combine_chunks(uint64_t *rp, const uint64_t *c, size_t m)
+{
+  if (m < from_dec_dc_threshold || m < 2) {
+    size_t n = 0;
+    for (size_t i = m; i > 0; --i) {
+      uint64_t carry = limbs_mul_1(rp, rp, n, POW10_19);
+      carry += limbs_add_1(rp, rp, n, c[i - 1]);
+      if (carry != 0) {
+        rp[n++] = carry;
+      }
+    }
+    for (; n < m; ++n) {
+      rp[n] = 0;
+    }
+    return;
+  }
+
+  unsigned k = 0;
+  while ((size_t) 2 << k < m) {
+    ++k;
+  }
+  size_t h = (size_t) 1 << k;
+  const std::vector<uint64_t> &pow = limbs_pow10_cached(k);
+  size_t pn = pow.size();
+
+  std::vector<uint64_t> high(m - h);
+  combine_chunks(high.data(), c + h, m - h);
+  size_t hn = limbs_normalized_size(high.data(), high.size());
+
+  combine_chunks(rp, c, h);
+  for (size_t i = h; i < m; ++i) {
+    rp[i] = 0;
+  }
+  if (hn == 0) {
+    return;
+  }
+
+  // rp += high * 10^(19h); the product is below 10^(19m) < B^m
+  std::vector<uint64_t> prod(hn + pn);
+  if (hn >= pn) {
+    limbs_mul(prod.data(), high.data(), hn, pow.data(), pn);
+  } else {
+    limbs_mul(prod.data(), pow.data(), pn, high.data(), hn);
+  }
+  size_t prodn = limbs_normalized_size(prod.data(), prod.size());
+  limbs_add(rp, rp, m, prod.data(), prodn);
+}
+
+bool limbs_from_dec(uint64_t *rp, const char *str, size_t len)
+{
+  // chunk 0 is the last 19 digits, chunk m-1 the (possibly short) first
+  size_t m = (len + DIGITS_PER_LIMB - 1) / DIGITS_PER_LIMB;
+  std::vector<uint64_t> chunks(m);
+  size_t first = len - DIGITS_PER_LIMB * (m - 1);
+  if (!parse_chunk(str, first, &chunks[m - 1])) {
+    return false;
+  }
+  for (size_t i = m - 1; i > 0; --i) {
+    const char *p = str + first + DIGITS_PER_LIMB * (m - 1 - i);
+    if (!parse_chunk(p, DIGITS_PER_LIMB, &chunks[i - 1])) {
+      return false;
+    }
+  }
+
+  combine_chunks(rp, chunks.data(), m);
+  return true;
+}
+
+bool limbs_from_hex(uint64_t *rp, const char *str, size_t len)
+{
+  // nibble value of every byte, or 0xFF for non-hex-digits
+  static const struct HexTable {
+    unsigned char value[256];
+    HexTable()
+    {
+      memset(value, 0xFF, sizeof(value));
+      for (int i = 0; i < 10; ++i) {
+        value['0' + i] = i;
+      }
+      for (int i = 0; i < 6; ++i) {
+        value['a' + i] = value['A' + i] = 10 + i;
+      }
+    }
+  } table;
+
+  // limb i holds the 16 digits ending 16*i characters from the end
+  size_t n = (len + 15) / 16;
+  for (size_t i = 0; i < n; ++i) {
+    size_t end = len - 16 * i;
+    size_t begin = end >= 16 ? end - 16 : 0;
+    uint64_t limb = 0;
+    unsigned bad = 0;
+    for (size_t j = begin; j < end; ++j) {
+      unsigned char nibble = table.value[(unsigned char) str[j]];
+      bad |= nibble;
+      limb = (limb << 4) | (nibble & 0xF);
+    }
+    if (bad & 0x80) {
+      return false;
+    }
+    rp[i] = limb;
+  }
+  return true;
+}
@@ -0,0 +1,131 @@
+#include <cmath>
+#include <stdexcept>
+#include "bigint.h"
+
+//! @file
+//! Integer roots of BigInt values by Newton's method with precision
+//! doubling, and perfect square detection.
+
+// Number of bits in the magnitude of x (0 for 0).
+static size_t bit_length(const BigInt &x)
+{
+  LimbSpan v = x.get_bit_vector();
+  size_t n = v.size();
+  while (n > 0 && v[n - 1] == 0) {
+    --n;
+  }
+  return n == 0 ? 0 : 64 * n - __builtin_clzll(v[n - 1]);
+}
+
+// floor(n^(1/k)) for n >= 0 and k >= 2.
+static BigInt root(const BigInt &n, unsigned k)
+{
+  size_t bits = bit_length(n);
+  if (bits == 0) {
+    return BigInt();
+  }
+  if (k >= bits) {
+    // 1 <= n < 2^k, so the root is 1 (and 2^k itself could be huge)
+    return BigInt(1);
+  }
+  size_t root_bits = (bits + k - 1) / k;
+
+  if (root_bits <= 32) {
+    // a floating-point estimate from the leading 64 bits is within 1
+    // of the root; settle the last unit with exact powers
+    LimbSpan v = n.get_bit_vector();
+    size_t shift = bits > 64 ? bits - 64 : 0;
+    uint64_t top = v[shift / 64] >> (shift % 64);
+    if (shift % 64 != 0 && shift / 64 + 1 < v.size()) {
+      top |= v[shift / 64 + 1] << (64 - shift % 64);
+    }
+    double estimate = std::exp2((std::log2((double) top) + (double) shift) / k);
+    BigInt r((uint64_t) estimate);
+    while (r.pow(k) > n) {
+      r -= BigInt(1);
+    }
+    while ((r + BigInt(1)).pow(k) <= n) {
+      r += BigInt(1);
+    }
+    return r;
+  }
+
+  // The root of the leading bits of n, scaled up, is an estimate above
+  // the root with about half of its bits correct; one Newton step then
+  // (nearly) doubles that, so each level of the recursion costs about
+  // as much as the divisions at its own precision. A few guard bits
+  // absorb the error growth of a step for larger k.
+  unsigned guard = 2 + (32 - __builtin_clz(k));
+  size_t s = root_bits / 2 > guard ? root_bits / 2 - guard : 1;
+  BigInt high = n;
+  high >>= (unsigned) (k * s);
+  BigInt x = root(high, k) + BigInt(1);
+  x <<= (unsigned) s;
+
+  // Newton's iteration x -> ((k-1) x + n / x^(k-1)) / k, in integers,
+  // never goes below the root when started above it, and decreases
+  // until it reaches it.
+  BigInt kk(k), k1(k - 1);
+  while (true) {
+    BigInt xk1 = x.pow(k - 1);
+    BigInt sum = n / xk1;
+    sum.addmul(x, k1);
+    x = sum / kk;
+    BigInt xk = x.pow(k);
+    if (xk <= n) {
+      return x;
+    }
+  }
+}
+
+BigInt BigInt::isqrt() const
+{
+  if (is_negative()) {
+    throw std::invalid_argument("square root of a negative value");
+  }
+  return root(*this, 2);
+}
+
+BigInt BigInt::iroot(unsigned k) const
+{
+  if (k == 0) {
+    throw std::invalid_argument("zeroth root");
+  }
+  if (k == 1) {
+    return *this;
+  }
+  if (is_negative()) {
+    if (k % 2 == 0) {
+      throw std::invalid_argument("even root of a negative value");
+    }
+    return -root(-*this, k);
+  }
+  return root(*this, k);
+}
+
+bool BigInt::is_perfect_square() const
+{
+  if (is_negative()) {
+    return false;
+  }
+
+  // Most non-squares are rejected by their residues modulo 64, 63, 11
+  // and 17, where only 12, 16, 6 and 9 residues are squares (bit r of
+  // each mask is set if r is a square); together, these leave about 1
+  // non-square in 70 for the root computation.
+  LimbSpan v = get_bit_vector();
+  if (!((0x202021202030213UL >> (v[0] % 64)) & 1)) {
+    return false;
+  }
+  uint64_t rem = 0;
+  for (size_t i = v.size(); i > 0; --i) {
+    rem = (uint64_t) ((((unsigned __int128) rem << 64) | v[i - 1]) % (63 * 11 * 17));
+  }
+  if (!((0x402483012450293UL >> (rem % 63)) & 1) || !((0x23bUL >> (rem % 11)) & 1) ||
+      !((0x1a317UL >> (rem % 17)) & 1)) {
+    return false;
+  }
+
+  BigInt r = isqrt();
+  return r * r == *this;
+}
@@ -1,7 +1,13 @@
+#include <cstdlib>
+#include <memory_resource>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
+#include <type_traits>
 #include "bigint.h"
+#include "bigint_limbs.h"
+#include "bigint_mod.h"
+#include "fixed_int.h"
 #include "tctest.h"
 
 struct TestObjs {
@@ -24,14 +30,36 @@ struct TestObjs {
 TestObjs *setup();
 void cleanup(TestObjs *objs);
 
+// When the environment variable BIGINT_TESTS_ARENA is set, each test
+// runs with the BigInt limbs allocated from an arena, which setup()
+// creates and cleanup() releases once the test objects are gone.
+std::pmr::monotonic_buffer_resource *test_arena;
+LimbResourceScope *test_arena_scope;
+
 // Verify that a BigInt contains appropriate data by checking the
-// contents of its internal vector of uint64_t values.
+// contents of its internal array of uint64_t values.
 // This allows us to validate the contents of a BigInt object
 // without needing to rely on member functions other than get_bit_vector().
 // Throws std::runtime_error if the actual values don't exactly match
 // the expected values.
 void check_contents(const BigInt &bigint, std::initializer_list<uint64_t> expected_vals);
 
+// Fill a vector with n pseudo-random limbs (deterministic for a given
+// seed), for tests that need operands too large to write out by hand.
+std::vector<uint64_t> random_limbs(size_t n, uint64_t seed);
+
+// Build a BigInt from a vector of limbs (least significant first).
+BigInt from_limbs(const std::vector<uint64_t> &limbs, bool negative = false);
+
+// Compute the product of two limb vectors with the schoolbook kernel,
+// as a reference result for the faster multiplication algorithms.
+BigInt schoolbook_product(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b);
+
+// Check every FixedInt<Bits> operation against the BigInt result
+// reduced modulo 2^Bits, for operands derived from the given seed.
+template <unsigned Bits>
+void check_fixed_int(uint64_t seed);
+
 // prototypes of test functions
 void test_default_ctor(TestObjs *objs);
 void test_u64_ctor(TestObjs *objs);
@@ -52,15 +80,47 @@ void test_lshift_1(TestObjs *objs);
 void test_lshift_2(TestObjs *objs);
 void test_mul_1(TestObjs *objs);
 void test_mul_2(TestObjs *objs);
+void test_mul_karatsuba(TestObjs *objs);
+void test_mul_unbalanced(TestObjs *objs);
+void test_mul_toom3(TestObjs *objs);
+void test_mul_ntt(TestObjs *objs);
 void test_compare_1(TestObjs *objs);
 void test_compare_2(TestObjs *objs);
 void test_div_1(TestObjs *objs);
 void test_div_2(TestObjs *objs);
+void test_div_3(TestObjs *objs);
+void test_div_4(TestObjs *objs);
+void test_div_bz(TestObjs *objs);
+void test_mod_1(TestObjs *objs);
+void test_divmod(TestObjs *objs);
 void test_to_hex_1(TestObjs *objs);
 void test_to_hex_2(TestObjs *objs);
 void test_to_dec_1(TestObjs *objs);
 void test_to_dec_2(TestObjs *objs);
+void test_to_dec_3(TestObjs *objs);
 void test_unary_operator(TestObjs *objs);
+void test_from_dec(TestObjs *objs);
+void test_from_hex(TestObjs *objs);
+void test_inline_storage(TestObjs *objs);
+void test_move(TestObjs *objs);
+void test_compound_assign(TestObjs *objs);
+void test_shift_assign(TestObjs *objs);
+void test_fused_mul_add(TestObjs *objs);
+void test_fused_add_shift(TestObjs *objs);
+void test_memory_resource(TestObjs *objs);
+void test_asm_kernels(TestObjs *objs);
+void test_modpow(TestObjs *objs);
+void test_mod_context(TestObjs *objs);
+void test_gcd(TestObjs *objs);
+void test_isqrt(TestObjs *objs);
+void test_rshift(TestObjs *objs);
+void test_bitwise(TestObjs *objs);
+void test_square(TestObjs *objs);
+void test_pow(TestObjs *objs);
+void test_factorial(TestObjs *objs);
+void test_is_prime(TestObjs *objs);
+void test_fixed_int(TestObjs *objs);
+void test_big_literal(TestObjs *objs);
 // TODO: declare additional test functions
 
 int main(int argc, char **argv) {
@@ -75,7 +135,6 @@ int main(int argc, char **argv) {
   TEST(test_initlist_ctor);
   TEST(test_copy_ctor);
   TEST(test_get_bits);
-  /*
   TEST(test_add_1);
   TEST(test_add_2);
   TEST(test_add_3);
@@ -92,17 +151,46 @@ int main(int argc, char **argv) {
   TEST(test_mul_2);
   TEST(test_compare_1);
   TEST(test_compare_2);
+  TEST(test_mul_karatsuba);
+  TEST(test_mul_unbalanced);
+  TEST(test_mul_toom3);
+  TEST(test_mul_ntt);
   TEST(test_div_1);
   TEST(test_div_2);
-  */
+  TEST(test_div_3);
+  TEST(test_div_4);
+  TEST(test_div_bz);
+  TEST(test_mod_1);
+  TEST(test_divmod);
   TEST(test_to_hex_1);
   TEST(test_to_hex_2);
-  /*
   TEST(test_to_dec_1);
   TEST(test_to_dec_2);
-  */
+  TEST(test_to_dec_3);
   // TODO: add calls to TEST for additional test functions
   TEST(test_unary_operator);
+  TEST(test_from_dec);
+  TEST(test_from_hex);
+  TEST(test_inline_storage);
+  TEST(test_move);
+  TEST(test_compound_assign);
+  TEST(test_shift_assign);
+  TEST(test_fused_mul_add);
+  TEST(test_fused_add_shift);
+  TEST(test_memory_resource);
+  TEST(test_asm_kernels);
+  TEST(test_modpow);
+  TEST(test_mod_context);
+  TEST(test_gcd);
+  TEST(test_isqrt);
+  TEST(test_rshift);
+  TEST(test_bitwise);
+  TEST(test_square);
+  TEST(test_pow);
+  TEST(test_factorial);
+  TEST(test_is_prime);
+  TEST(test_fixed_int);
+  TEST(test_big_literal);
 
   TEST_FINI();
 }
@@ -126,15 +214,23 @@ TestObjs::TestObjs()
 }
 
 TestObjs *setup() {
+  if (getenv("BIGINT_TESTS_ARENA")) {
+    test_arena = new std::pmr::monotonic_buffer_resource;
+    test_arena_scope = new LimbResourceScope(test_arena);
+  }
   return new TestObjs;
 }
 
 void cleanup(TestObjs *objs) {
   delete objs;
+  delete test_arena_scope;
+  delete test_arena;
+  test_arena_scope = nullptr;
+  test_arena = nullptr;
 }
 
 void check_contents(const BigInt &bigint, std::initializer_list<uint64_t> expected_vals) {
-  const std::vector<uint64_t> &actual_vals = bigint.get_bit_vector();
+  LimbSpan actual_vals = bigint.get_bit_vector();
 
   auto i = actual_vals.begin();
   auto j = expected_vals.begin();
@@ -182,6 +278,35 @@ void check_contents(const BigInt &bigint, std::initializer_list<uint64_t> expect
   }
 }
 
+std::vector<uint64_t> random_limbs(size_t n, uint64_t seed) {
+  // xorshift64*: plenty for generating test operands
+  uint64_t state = seed * 0x9E3779B97F4A7C15UL + 1;
+  std::vector<uint64_t> limbs(n);
+  for (size_t i = 0; i < n; ++i) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    limbs[i] = state * 0x2545F4914F6CDD1DUL;
+  }
+  return limbs;
+}
+
+BigInt from_limbs(const std::vector<uint64_t> &limbs, bool negative) {
+  BigInt result;
+  for (size_t i = limbs.size(); i > 0; --i) {
+    result = (result << 64) + BigInt(limbs[i - 1]);
+  }
+  return negative ? -result : result;
+}
+
+BigInt schoolbook_product(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) {
+  const std::vector<uint64_t> &big = a.size() >= b.size() ? a : b;
+  const std::vector<uint64_t> &small = a.size() >= b.size() ? b : a;
+  std::vector<uint64_t> product(a.size() + b.size());
+  limbs_mul_basecase(product.data(), big.data(), big.size(), small.data(), small.size());
+  return from_limbs(product);
+}
+
 void test_default_ctor(TestObjs *objs) {
   check_contents(objs->zero, { 0UL });
   ASSERT(!objs->zero.is_negative());
@@ -482,6 +607,100 @@ void test_mul_2(TestObjs *) {
   }
 }
 
+void test_mul_karatsuba(TestObjs *) {
+  // balanced products large enough to go through the Karatsuba path,
+  // checked against the schoolbook kernel
+
+  size_t sizes[] = { mul_karatsuba_threshold, mul_karatsuba_threshold + 1,
+                     3 * mul_karatsuba_threshold + 7, 10 * mul_karatsuba_threshold };
+  for (size_t n : sizes) {
+    std::vector<uint64_t> a = random_limbs(n, n);
+    std::vector<uint64_t> b = random_limbs(n, n + 1000);
+    BigInt result = from_limbs(a) * from_limbs(b);
+    ASSERT(result == schoolbook_product(a, b));
+    ASSERT(!result.is_negative());
+  }
+
+  // all-ones operands exercise every carry: (2^k - 1)^2 = 2^2k - 2^(k+1) + 1
+  {
+    unsigned k = 64 * 4 * mul_karatsuba_threshold;
+    BigInt ones = (BigInt(1) << k) - BigInt(1);
+    BigInt expected = (BigInt(1) << (2 * k)) - (BigInt(1) << (k + 1)) + BigInt(1);
+    ASSERT(ones * ones == expected);
+  }
+}
+
+void test_mul_unbalanced(TestObjs *) {
+  // products of operands with very different sizes and mixed signs
+
+  std::vector<uint64_t> a = random_limbs(7 * mul_karatsuba_threshold + 5, 1);
+  std::vector<uint64_t> b = random_limbs(2 * mul_karatsuba_threshold, 2);
+  BigInt expected = schoolbook_product(a, b);
+
+  BigInt result1 = from_limbs(a) * from_limbs(b, true);
+  ASSERT(result1.is_negative());
+  ASSERT(result1 == -expected);
+
+  BigInt result2 = from_limbs(b, true) * from_limbs(a, true);
+  ASSERT(!result2.is_negative());
+  ASSERT(result2 == expected);
+
+  BigInt result3 = from_limbs(a, true) * BigInt();
+  check_contents(result3, { 0UL });
+  ASSERT(!result3.is_negative());
+}
+
+void test_mul_toom3(TestObjs *) {
+  // balanced products in the Toom-3 range, checked against the
+  // schoolbook kernel; the sizes cover every remainder mod 3
+
+  size_t sizes[] = { mul_toom3_threshold, mul_toom3_threshold + 1,
+                     mul_toom3_threshold + 2, 4 * mul_toom3_threshold + 1 };
+  for (size_t n : sizes) {
+    std::vector<uint64_t> a = random_limbs(n, 3 * n);
+    std::vector<uint64_t> b = random_limbs(n, 3 * n + 1);
+    BigInt result = from_limbs(a, true) * from_limbs(b);
+    ASSERT(result == -schoolbook_product(a, b));
+  }
+
+  // with tiny thresholds, small operands recurse through every tier
+  // (a threshold below the Karatsuba minimum of 4 limbs is safe)
+  size_t saved_karatsuba = mul_karatsuba_threshold;
+  size_t saved_toom3 = mul_toom3_threshold;
+  mul_karatsuba_threshold = 1;
+  mul_toom3_threshold = 9;
+  bool all_match = true;
+  for (size_t n = 1; n < 80; ++n) {
+    std::vector<uint64_t> a = random_limbs(n, n + 7);
+    std::vector<uint64_t> b(n, 0xFFFFFFFFFFFFFFFFUL);
+    all_match = all_match && (from_limbs(a) * from_limbs(b) == schoolbook_product(a, b));
+  }
+  mul_karatsuba_threshold = saved_karatsuba;
+  mul_toom3_threshold = saved_toom3;
+  ASSERT(all_match);
+}
+
+void test_mul_ntt(TestObjs *) {
+  // the transform tier, checked against the schoolbook kernel; the
+  // threshold is lowered so the reference products stay cheap
+
+  size_t saved_ntt = mul_ntt_threshold;
+  mul_ntt_threshold = 40;
+  bool all_match = true;
+  size_t sizes[][2] = { { 40, 40 }, { 41, 40 }, { 300, 45 }, { 513, 511 }, { 1000, 999 } };
+  for (auto &size : sizes) {
+    std::vector<uint64_t> a = random_limbs(size[0], size[0] * 5);
+    std::vector<uint64_t> b = random_limbs(size[1], size[1] * 5 + 1);
+    all_match = all_match && (from_limbs(a) * from_limbs(b) == schoolbook_product(a, b));
+  }
+
+  // maximal coefficients: every limb of both operands all ones
+  std::vector<uint64_t> ones(700, 0xFFFFFFFFFFFFFFFFUL);
+  all_match = all_match && (from_limbs(ones) * from_limbs(ones) == schoolbook_product(ones, ones));
+  mul_ntt_threshold = saved_ntt;
+  ASSERT(all_match);
+}
+
 void test_compare_1(TestObjs *objs) {
   // some basic tests for compare
   ASSERT(objs->zero.compare(objs->zero) == 0);
@@ -535,6 +754,168 @@ void test_div_2(TestObjs *) {
   }
 }
 
+void test_div_3(TestObjs *objs) {
+  // division corner cases: zero divisor, small dividend, signs
+
+  try {
+    objs->nine / objs->zero;
+    FAIL("dividing by zero should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+
+  BigInt result1 = objs->three / objs->negative_nine;
+  check_contents(result1, { 0UL });
+  ASSERT(!result1.is_negative());
+
+  BigInt result2 = objs->negative_nine / objs->negative_three;
+  check_contents(result2, { 3UL });
+  ASSERT(!result2.is_negative());
+
+  BigInt result3 = objs->two_pow_64 / objs->u64_max;
+  check_contents(result3, { 1UL });
+
+  BigInt result4 = objs->negative_two_pow_64 / objs->two_pow_64;
+  check_contents(result4, { 1UL });
+  ASSERT(result4.is_negative());
+}
+
+void test_div_4(TestObjs *) {
+  // long division on random and adversarial operands, checked through
+  // the defining property q*b <= a < (q+1)*b
+
+  bool all_match = true;
+  size_t sizes[][2] = { { 2, 1 }, { 2, 2 }, { 7, 3 }, { 40, 39 }, { 60, 17 }, { 120, 80 } };
+  for (auto &size : sizes) {
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+      std::vector<uint64_t> a = random_limbs(size[0], seed * 31 + size[0]);
+      std::vector<uint64_t> b = random_limbs(size[1], seed * 37 + size[1]);
+      if (seed == 1) {
+        // divisor with a small top limb: a large normalization shift
+        b.back() = 1;
+      } else if (seed == 2) {
+        // patterns that make the trial quotient overshoot
+        for (size_t i = 0; i < a.size(); ++i) {
+          a[i] = i % 2 ? 0x8000000000000000UL : 0;
+        }
+        b.back() = 0x8000000000000000UL;
+        b[0] = 1;
+      } else if (seed == 3) {
+        for (uint64_t &limb : a) {
+          limb = 0xFFFFFFFFFFFFFFFFUL;
+        }
+      }
+      BigInt dividend = from_limbs(a), divisor = from_limbs(b);
+      BigInt q = dividend / divisor;
+      all_match = all_match && q * divisor <= dividend && (q + BigInt(1)) * divisor > dividend;
+    }
+  }
+  ASSERT(all_match);
+}
+
+void test_div_bz(TestObjs *) {
+  // recursive division, checked against schoolbook long division
+  // (including the remainder) for sizes that exercise the partial top
+  // quotient block and every recursion depth
+
+  bool all_match = true;
+  size_t sizes[][2] = { { 2 * div_bz_threshold, div_bz_threshold },
+                        { 5 * div_bz_threshold + 3, 2 * div_bz_threshold + 1 },
+                        { 9 * div_bz_threshold, 4 * div_bz_threshold - 1 },
+                        { 300, 3 }, { 40, 20 } };
+  for (auto &size : sizes) {
+    size_t nn = size[0], dn = size[1];
+    std::vector<uint64_t> a = random_limbs(nn, nn), b = random_limbs(dn, dn + 3);
+    b.back() >>= dn % 64; // vary the normalization shift
+    if (b.back() == 0) {
+      b.back() = 1;
+    }
+    std::vector<uint64_t> q1(nn - dn + 1), r1(dn), q2(nn - dn + 1), r2(dn);
+    limbs_div_qr_bz(q1.data(), r1.data(), a.data(), nn, b.data(), dn);
+    limbs_div_qr_schoolbook(q2.data(), r2.data(), a.data(), nn, b.data(), dn);
+    all_match = all_match && q1 == q2 && r1 == r2;
+  }
+  ASSERT(all_match);
+
+  // and through the operators, with the dispatch picking the tier
+  std::vector<uint64_t> a = random_limbs(6 * div_bz_threshold, 11);
+  std::vector<uint64_t> b = random_limbs(3 * div_bz_threshold, 12);
+  BigInt dividend = from_limbs(a, true), divisor = from_limbs(b);
+  BigInt q = dividend / divisor, r = dividend % divisor;
+  ASSERT(q * divisor + r == dividend);
+  ASSERT(r.is_negative());
+  ASSERT(-r < divisor);
+}
+
+void test_mod_1(TestObjs *objs) {
+  // remainder follows the sign of the dividend
+
+  BigInt result1 = objs->nine % objs->two;
+  check_contents(result1, { 1UL });
+  ASSERT(!result1.is_negative());
+
+  BigInt result2 = objs->negative_nine % objs->two;
+  check_contents(result2, { 1UL });
+  ASSERT(result2.is_negative());
+
+  BigInt result3 = objs->nine % objs->negative_three;
+  check_contents(result3, { 0UL });
+  ASSERT(!result3.is_negative());
+
+  BigInt result4 = objs->three % objs->negative_nine;
+  check_contents(result4, { 3UL });
+  ASSERT(!result4.is_negative());
+
+  BigInt result5 = objs->two_pow_64 % objs->u64_max;
+  check_contents(result5, { 1UL });
+
+  try {
+    objs->nine % objs->zero;
+    FAIL("remainder by zero should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_divmod(TestObjs *objs) {
+  // divmod and the compound assignment operators agree with / and %
+
+  std::pair<BigInt, BigInt> result1 = objs->negative_nine.divmod(objs->two);
+  check_contents(result1.first, { 4UL });
+  ASSERT(result1.first.is_negative());
+  check_contents(result1.second, { 1UL });
+  ASSERT(result1.second.is_negative());
+
+  std::pair<BigInt, BigInt> result2 = objs->three.divmod(objs->nine);
+  check_contents(result2.first, { 0UL });
+  check_contents(result2.second, { 3UL });
+
+  {
+    BigInt left({0x5a1f7b06e95d205bUL, 0x16bef383084c9bf5UL, 0x6bfd5cb9a0cfa403UL, 0xbb47e519c0ffc392UL, 0xc8c47a8ab9cc20afUL, 0x30302fb07ef81d25UL, 0x8b8bcb6df3f72911UL, 0x3de679169dc89703UL, 0x48f52b428f255e1dUL, 0xd623c2e8a460f5beUL, 0xae2df81a84808054UL, 0xcfb038910d158d63UL, 0xcf97bc9UL});
+    BigInt right({0xe1d191b09fd571e7UL, 0xd6e34973337d88fdUL, 0x7235628c33211b03UL, 0xe0bbc74b5d7fe26aUL, 0xf6242ed96eb2c8d9UL, 0x3b0cad8e5dd18f5UL, 0x558c283a839910c0UL, 0xbb4df9de72952652UL, 0xed8b519e3c63ce56UL, 0xe96f9c8454bde1c4UL, 0x76b62db592951f97UL, 0x577341UL});
+    std::pair<BigInt, BigInt> result = left.divmod(right);
+    check_contents(result.first, {0xfb3e6b02be39b6ceUL, 0x25UL});
+    ASSERT(result.second == left % right);
+    ASSERT(result.first * right + result.second == left);
+  }
+
+  BigInt val = objs->negative_nine;
+  val /= objs->two;
+  check_contents(val, { 4UL });
+  ASSERT(val.is_negative());
+  val %= objs->three;
+  check_contents(val, { 1UL });
+  ASSERT(val.is_negative());
+
+  // self-division through the compound operators
+  BigInt self = objs->two_pow_64;
+  self %= self;
+  check_contents(self, { 0UL });
+  self = objs->u64_max;
+  self /= self;
+  check_contents(self, { 1UL });
+}
+
 void test_to_hex_1(TestObjs *objs) {
   // some basic tests for to_hex()
 
@@ -591,6 +972,33 @@ void test_to_dec_2(TestObjs *) {
   }
 }
 
+void test_to_dec_3(TestObjs *objs) {
+  // to_dec() on values long enough for the recursive split, where
+  // internal runs of zeros must be padded correctly
+
+  BigInt ten(10UL), pow = objs->one;
+  for (int i = 0; i < 2000; ++i) {
+    pow = pow * ten;
+  }
+  std::string result1 = pow.to_dec();
+  ASSERT(result1 == "1" + std::string(2000, '0'));
+
+  std::string result2 = (pow - objs->one).to_dec();
+  ASSERT(result2 == std::string(2000, '9'));
+
+  std::string result3 = (-(pow + objs->nine)).to_dec();
+  ASSERT(result3 == "-1" + std::string(1999, '0') + "9");
+
+  // the recursive conversion must agree with the basecase
+  BigInt val = from_limbs(random_limbs(4 * to_dec_dc_threshold + 5, 99));
+  std::string recursive = val.to_dec();
+  size_t saved = to_dec_dc_threshold;
+  to_dec_dc_threshold = SIZE_MAX;
+  std::string basecase = val.to_dec();
+  to_dec_dc_threshold = saved;
+  ASSERT(recursive == basecase);
+}
+
 void test_unary_operator(TestObjs *objs) {
   // Basic test for unary minus
   BigInt result1 = -objs->zero;
@@ -611,3 +1019,1246 @@ void test_unary_operator(TestObjs *objs) {
 }
 
 // TODO: implement additional test functions
+
+void test_from_dec(TestObjs *) {
+  // parsing decimal strings
+
+  BigInt result1 = BigInt::from_dec("0");
+  check_contents(result1, { 0UL });
+  ASSERT(!result1.is_negative());
+
+  BigInt result2 = BigInt::from_dec("-0000");
+  check_contents(result2, { 0UL });
+  ASSERT(!result2.is_negative());
+
+  BigInt result3 = BigInt::from_dec("18446744073709551615");
+  check_contents(result3, { 0xFFFFFFFFFFFFFFFFUL });
+
+  BigInt result4 = BigInt::from_dec("-703527900324720116021349050368162523567079645895");
+  check_contents(result4, { 0x361adeb15b6962c7UL, 0x31a5b3c012d2a685UL, 0x7b3b4839UL });
+  ASSERT(result4.is_negative());
+
+  // long strings go through the recursive combination; every length
+  // modulo 19 exercises a different leading chunk
+  bool all_match = true;
+  for (size_t len = 1; len < 40 * from_dec_dc_threshold; len += 37) {
+    std::string digits;
+    uint64_t state = len;
+    for (size_t i = 0; i < len; ++i) {
+      state = state * 6364136223846793005UL + 1442695040888963407UL;
+      digits.push_back('0' + (state >> 33) % 10);
+    }
+    digits[0] = '1' + len % 9;
+    all_match = all_match && BigInt::from_dec(digits).to_dec() == digits;
+  }
+  ASSERT(all_match);
+
+  const char *invalid[] = { "", "-", "12a4", " 12", "1234567890123456789012345x", "+5", "--1" };
+  for (const char *str : invalid) {
+    try {
+      BigInt::from_dec(str);
+      FAIL("parsing an invalid decimal string should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+}
+
+void test_from_hex(TestObjs *) {
+  // parsing hexadecimal strings
+
+  BigInt result1 = BigInt::from_hex("ffffffffffffffff");
+  check_contents(result1, { 0xFFFFFFFFFFFFFFFFUL });
+
+  BigInt result2 = BigInt::from_hex("-10000000000000000");
+  check_contents(result2, { 0UL, 1UL });
+  ASSERT(result2.is_negative());
+
+  BigInt result3 = BigInt::from_hex("00000000000000000000000000ABCdef");
+  check_contents(result3, { 0xabcdefUL });
+
+  BigInt val({0xd8b5422df2c7e5d4UL, 0x2186595636ed41d7UL, 0xcf498dc4c634eb41UL, 0xa6579a3f9d2aab0cUL, 0xb5cbefaf0e63a6e3UL, 0xf419b0aadf4d14f1UL, 0xcec650d523acc64eUL, 0x14318cf757a58UL}, true);
+  ASSERT(BigInt::from_hex(val.to_hex()) == val);
+
+  const char *invalid[] = { "", "-", "0x12", "12g4", "ffffffffffffffff_" };
+  for (const char *str : invalid) {
+    try {
+      BigInt::from_hex(str);
+      FAIL("parsing an invalid hexadecimal string should throw an exception");
+    } catch (std::invalid_argument &ex) {
+      // good
+    }
+  }
+}
+
+void test_inline_storage(TestObjs *objs) {
+  // small values keep their limbs inside the object; larger ones move
+  // to the heap, and copies/assignments work across the boundary
+
+  BigInt small({1UL, 2UL, 3UL, 4UL});
+  const char *p = reinterpret_cast<const char *>(small.get_bit_vector().data());
+  const char *obj = reinterpret_cast<const char *>(&small);
+  ASSERT(p >= obj && p < obj + sizeof(BigInt));
+
+  BigInt big = small << 64;
+  check_contents(big, { 0UL, 1UL, 2UL, 3UL, 4UL });
+  p = reinterpret_cast<const char *>(big.get_bit_vector().data());
+  obj = reinterpret_cast<const char *>(&big);
+  ASSERT(p < obj || p >= obj + sizeof(BigInt));
+
+  // heap value assigned over an inline one, and vice versa
+  BigInt result1 = objs->three;
+  result1 = big;
+  check_contents(result1, { 0UL, 1UL, 2UL, 3UL, 4UL });
+  result1 = objs->three;
+  check_contents(result1, { 3UL });
+
+  // growing a value one limb at a time across the inline capacity
+  BigInt result2 = objs->one;
+  for (unsigned i = 1; i <= 8; ++i) {
+    result2 = result2 << 64;
+    ASSERT(result2.get_bit_vector().size() == i + 1);
+    ASSERT(result2.get_bits(i) == 1UL);
+  }
+  result2 = result2 - (objs->one << 512);
+  ASSERT(result2.to_dec() == "0");
+  check_contents(result2, { 0UL });
+}
+
+void test_move(TestObjs *objs) {
+  // moves take over the value and leave the source equal to 0
+
+  ASSERT(std::is_nothrow_move_constructible<BigInt>::value);
+  ASSERT(std::is_nothrow_move_assignable<BigInt>::value);
+
+  BigInt big = from_limbs(random_limbs(40, 5), true);
+  BigInt copy(big);
+  const uint64_t *limbs = big.get_bit_vector().data();
+
+  BigInt result1(std::move(big));
+  ASSERT(result1 == copy);
+  ASSERT(result1.get_bit_vector().data() == limbs);
+  check_contents(big, { 0UL });
+  ASSERT(!big.is_negative());
+
+  BigInt result2 = objs->nine;
+  result2 = std::move(result1);
+  ASSERT(result2 == copy);
+  ASSERT(result2.get_bit_vector().data() == limbs);
+  check_contents(result1, { 0UL });
+
+  // small values are copied out of the inline storage
+  BigInt result3 = objs->negative_nine;
+  result2 = std::move(result3);
+  check_contents(result2, { 9UL });
+  ASSERT(result2.is_negative());
+  check_contents(result3, { 0UL });
+
+  // self-move leaves the value alone
+  BigInt &alias = result2;
+  result2 = std::move(alias);
+  check_contents(result2, { 9UL });
+  ASSERT(result2.is_negative());
+}
+
+void test_compound_assign(TestObjs *objs) {
+  // +=, -= and *= agree with +, - and * for every combination of signs
+
+  BigInt vals[] = {
+    objs->zero, objs->one, objs->negative_nine, objs->u64_max, objs->negative_two_pow_64,
+    from_limbs(random_limbs(3, 1)), from_limbs(random_limbs(7, 2), true),
+    from_limbs(random_limbs(60, 3)), from_limbs(random_limbs(45, 4), true),
+  };
+  bool all_match = true;
+  for (const BigInt &a : vals) {
+    for (const BigInt &b : vals) {
+      BigInt sum = a, diff = a, prod = a;
+      sum += b;
+      diff -= b;
+      prod *= b;
+      all_match = all_match && sum == a + b && diff == a - b && prod == a * b;
+    }
+  }
+  ASSERT(all_match);
+
+  // the right-hand side may be the object itself
+  BigInt result1 = vals[8];
+  result1 += result1;
+  ASSERT(result1 == vals[8] + vals[8]);
+  result1 -= result1;
+  check_contents(result1, { 0UL });
+  ASSERT(!result1.is_negative());
+  BigInt result2 = vals[7];
+  result2 *= result2;
+  ASSERT(result2 == vals[7] * vals[7]);
+
+  // carries and borrows that change the length
+  BigInt result3 = objs->u64_max;
+  result3 += objs->one;
+  check_contents(result3, { 0UL, 1UL });
+  result3 -= objs->one;
+  check_contents(result3, { 0xFFFFFFFFFFFFFFFFUL });
+  result3 -= objs->two_pow_64;
+  check_contents(result3, { 1UL });
+  ASSERT(result3.is_negative());
+
+  // accumulating in a loop
+  BigInt acc;
+  for (unsigned i = 1; i <= 100; ++i) {
+    acc += BigInt(i);
+  }
+  ASSERT(acc.to_dec() == "5050");
+  BigInt fact(1);
+  for (unsigned i = 2; i <= 30; ++i) {
+    fact *= BigInt(i);
+  }
+  ASSERT(fact.to_dec() == "265252859812191058636308480000000");
+}
+
+void test_shift_assign(TestObjs *objs) {
+  // in-place shifts; right shifts of negative values round down
+
+  BigInt result1 = objs->three;
+  result1 <<= 130;
+  ASSERT(result1 == (objs->three << 130));
+  check_contents(result1, { 0UL, 0UL, 12UL });
+  result1 >>= 129;
+  check_contents(result1, { 6UL });
+  result1 <<= 0;
+  check_contents(result1, { 6UL });
+  result1 >>= 64;
+  check_contents(result1, { 0UL });
+
+  BigInt result2({0x123456789abcdef0UL, 0xfedcba9876543210UL, 0x1UL});
+  result2 <<= 64;
+  check_contents(result2, { 0UL, 0x123456789abcdef0UL, 0xfedcba9876543210UL, 0x1UL });
+  result2 >>= 68;
+  check_contents(result2, { 0x0123456789abcdefUL, 0x1fedcba987654321UL });
+
+  BigInt result3 = objs->negative_nine;
+  result3 >>= 1;
+  ASSERT(result3.to_dec() == "-5");
+  result3 >>= 1000;
+  ASSERT(result3.to_dec() == "-1");
+  result3 >>= 1;
+  ASSERT(result3.to_dec() == "-1");
+
+  BigInt result4 = objs->negative_two_pow_64;
+  result4 >>= 64;
+  ASSERT(result4.to_dec() == "-1");
+  result4 = objs->negative_two_pow_64;
+  result4 >>= 3;
+  check_contents(result4, { 0x2000000000000000UL });
+  ASSERT(result4.is_negative());
+  result4 = objs->negative_two_pow_64 - objs->one;
+  result4 >>= 64;
+  ASSERT(result4.to_dec() == "-2");
+
+  // a carry out of the rounding grows the value
+  BigInt result5({1UL, 0xFFFFFFFFFFFFFFFFUL}, true);
+  result5 >>= 64;
+  check_contents(result5, { 0UL, 1UL });
+  ASSERT(result5.is_negative());
+
+  try {
+    BigInt result6 = objs->negative_three;
+    result6 <<= 1;
+    FAIL("left shifting a negative value should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_fused_mul_add(TestObjs *objs) {
+  // addmul and submul, accumulating without a temporary product,
+  // agree with multiplying first and then adding
+
+  std::vector<uint64_t> ones(50, 0xFFFFFFFFFFFFFFFFUL);
+  BigInt vals[] = {
+    objs->zero, objs->one, objs->negative_nine, objs->u64_max, objs->negative_two_pow_64,
+    from_limbs(random_limbs(3, 21)), from_limbs(random_limbs(5, 22), true),
+    from_limbs(ones), from_limbs(random_limbs(40, 23), true), from_limbs(random_limbs(90, 24)),
+  };
+  bool all_match = true;
+  for (const BigInt &a : vals) {
+    for (const BigInt &b : vals) {
+      BigInt prod = a * b;
+      for (const BigInt &c : vals) {
+        BigInt acc = c;
+        acc.addmul(a, b);
+        BigInt acc2 = c;
+        acc2.submul(a, b);
+        all_match = all_match && acc == prod + c && acc2 == c - prod;
+      }
+    }
+  }
+  ASSERT(all_match);
+
+  // long, unbalanced products, accumulated one chunk at a time, with
+  // the difference changing sign
+  BigInt long_a = from_limbs(random_limbs(300, 25)), long_b = from_limbs(random_limbs(35, 26), true);
+  BigInt long_prod = long_a * long_b;
+  for (const BigInt &c : { objs->u64_max, -long_prod, long_prod, long_a }) {
+    BigInt acc = c;
+    acc.addmul(long_a, long_b);
+    BigInt acc2 = c;
+    acc2.submul(long_b, long_a);
+    all_match = all_match && acc == c + long_prod && acc2 == c - long_prod;
+  }
+  ASSERT(all_match);
+
+  // the product exactly cancelling the accumulator
+  BigInt result1 = from_limbs({ 1UL, 0xFFFFFFFFFFFFFFFEUL });
+  result1.submul(objs->u64_max, objs->u64_max);
+  check_contents(result1, { 0UL });
+  ASSERT(!result1.is_negative());
+
+  // accumulating a product of the accumulator into itself
+  BigInt result2 = vals[8];
+  result2.addmul(result2, vals[6]);
+  ASSERT(result2 == vals[8] + vals[8] * vals[6]);
+  result2 = vals[5];
+  result2.submul(result2, result2);
+  ASSERT(result2 == vals[5] - vals[5] * vals[5]);
+
+  // chained accumulation, and Horner's rule
+  BigInt result3;
+  result3.addmul(vals[5], vals[6]).submul(vals[7], vals[8]);
+  ASSERT(result3 == vals[5] * vals[6] - vals[7] * vals[8]);
+  BigInt poly;
+  for (unsigned i = 0; i < 10; ++i) {
+    BigInt next(i);
+    next.addmul(poly, objs->u64_max);
+    poly = next;
+  }
+  ASSERT(poly.to_hex() == "fffffffffffffffa0000000000000010ffffffffffffffe4000000000000001dffffffffffffffec000000000000000a00000000000000000000000000000005");
+
+  // the operators return plain BigInt values, so results can be
+  // stored with auto and queried directly
+  auto sum = objs->three + objs->nine;
+  ASSERT((std::is_same<decltype(sum), BigInt>::value));
+  ASSERT((objs->three * objs->negative_nine).to_dec() == "-27");
+  ASSERT((objs->three - objs->nine).compare(objs->negative_three * objs->two) == 0);
+  ASSERT(-(objs->three * objs->three) == objs->negative_nine);
+}
+
+void test_fused_add_shift(TestObjs *objs) {
+  // add_lshift and sub_lshift, in one pass
+
+  BigInt vals[] = {
+    objs->zero, objs->one, objs->u64_max, objs->two_pow_64, objs->nine,
+    from_limbs(random_limbs(6, 31)), from_limbs(random_limbs(6, 32)), from_limbs(random_limbs(20, 33)),
+  };
+  unsigned shifts[] = { 0, 1, 17, 63, 64, 65, 200 };
+  bool all_match = true;
+  for (const BigInt &a : vals) {
+    for (const BigInt &b : vals) {
+      for (unsigned n : shifts) {
+        all_match = all_match && a.add_lshift(b, n) == ((a + b) << n);
+        if (a >= b) {
+          all_match = all_match && a.sub_lshift(b, n) == ((a - b) << n);
+        }
+      }
+    }
+  }
+  ASSERT(all_match);
+
+  // negative operands with a non-negative sum
+  BigInt result1 = objs->nine.add_lshift(objs->negative_three, 4);
+  check_contents(result1, { 96UL });
+  BigInt result2 = objs->u64_max.add_lshift(objs->one, 1);
+  check_contents(result2, { 0UL, 2UL });
+  check_contents(objs->three.sub_lshift(objs->nine, 0), { 6UL });
+
+  try {
+    BigInt result3 = objs->three.sub_lshift(objs->nine, 1);
+    FAIL("left shifting a negative sum should throw an exception");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+// Memory resource that counts the allocations made through it.
+class CountingResource : public std::pmr::memory_resource {
+public:
+  unsigned allocs = 0;
+  unsigned live = 0;
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    ++allocs;
+    ++live;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    --live;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+void test_memory_resource(TestObjs *objs) {
+  // limbs are allocated from the resource selected by the innermost
+  // LimbResourceScope, and results can be copied out of the scope
+
+  CountingResource counter;
+  BigInt outside;
+  {
+    LimbResourceScope scope(&counter);
+
+    BigInt small = objs->u64_max * objs->u64_max + objs->one;
+    ASSERT(counter.allocs == 0);
+
+    BigInt big = from_limbs(random_limbs(12, 41));
+    BigInt prod = big * big;
+    ASSERT(counter.allocs > 0);
+    unsigned allocs = counter.allocs;
+
+    // a nested scope takes over, and restores the outer one on exit
+    {
+      CountingResource inner;
+      LimbResourceScope inner_scope(&inner);
+      BigInt sum = prod + big;
+      ASSERT(inner.allocs == 1);
+      ASSERT(counter.allocs == allocs);
+    }
+    BigInt copy(prod);
+    ASSERT(counter.allocs == allocs + 1);
+
+    // moving into a value with another resource copies the limbs
+    // rather than handing over storage the destination can't free
+    const uint64_t *limbs = copy.get_bit_vector().data();
+    outside = std::move(copy);
+    ASSERT(outside == prod);
+    ASSERT(outside.get_bit_vector().data() != limbs);
+    check_contents(copy, { 0UL });
+  }
+  ASSERT(counter.live == 0);
+  ASSERT(outside == BigInt(from_limbs(random_limbs(12, 41)) * from_limbs(random_limbs(12, 41))));
+}
+
+void test_asm_kernels(TestObjs *) {
+  // the assembly kernels (if this CPU can run them) agree with the
+  // portable ones, for every entry point into their unrolled loops,
+  // with carries rippling all the way through, and in place
+
+  if (!limbs_asm_supported()) {
+    return;
+  }
+
+  bool saved = limbs_asm_enabled;
+  bool all_match = true;
+  for (size_t n = 0; n <= 13; ++n) {
+    for (int pattern = 0; pattern < 2; ++pattern) {
+      std::vector<uint64_t> a = pattern ? std::vector<uint64_t>(n, 0xFFFFFFFFFFFFFFFFUL) : random_limbs(n + 1, n);
+      std::vector<uint64_t> b = pattern ? std::vector<uint64_t>(n, 0xFFFFFFFFFFFFFFFFUL) : random_limbs(n + 1, n + 50);
+      std::vector<uint64_t> c = pattern ? std::vector<uint64_t>(n, 0) : random_limbs(n + 1, n + 100);
+      a.resize(n);
+      b.resize(n);
+      c.resize(n);
+      uint64_t m = pattern ? 0xFFFFFFFFFFFFFFFFUL : b.empty() ? 3 : b[0];
+
+      std::vector<uint64_t> results[2][6];
+      uint64_t ret[2][6];
+      for (int use_asm = 0; use_asm < 2; ++use_asm) {
+        limbs_asm_enabled = use_asm;
+        std::vector<uint64_t> *r = results[use_asm];
+        for (int k = 0; k < 6; ++k) {
+          r[k] = c;
+        }
+        ret[use_asm][0] = limbs_add_n(r[0].data(), a.data(), b.data(), n);
+        ret[use_asm][1] = limbs_sub_n(r[1].data(), c.data(), b.data(), n);
+        ret[use_asm][2] = limbs_mul_1(r[2].data(), a.data(), n, m);
+        ret[use_asm][3] = limbs_addmul_1(r[3].data(), a.data(), n, m);
+        ret[use_asm][4] = limbs_submul_1(r[4].data(), a.data(), n, m);
+        ret[use_asm][5] = limbs_mul_1(r[5].data(), r[5].data(), n, m);
+      }
+      for (int k = 0; k < 6; ++k) {
+        all_match = all_match && ret[0][k] == ret[1][k] && results[0][k] == results[1][k];
+      }
+    }
+  }
+  limbs_asm_enabled = saved;
+  ASSERT(all_match);
+}
+
+void test_modpow(TestObjs *objs) {
+  // small values
+  ASSERT(BigInt(4).modpow(BigInt(13), BigInt(497)) == BigInt(445));
+  ASSERT(BigInt(2).modpow(BigInt(10), BigInt(1000)) == BigInt(24));
+  ASSERT(objs->three.modpow(objs->zero, objs->nine) == BigInt(1));
+  ASSERT(objs->three.modpow(objs->two, BigInt(1)) == BigInt(0));
+  ASSERT(objs->zero.modpow(objs->three, objs->nine) == BigInt(0));
+
+  // a negative base is reduced to its residue first: (-3)^3 = -27,
+  // and -27 mod 10 = 3
+  ASSERT(objs->negative_three.modpow(objs->three, BigInt(10)) == BigInt(3));
+
+  // compare with square-and-multiply, for odd and even moduli of
+  // several sizes (crossing the Karatsuba threshold), and bases both
+  // smaller and larger than the modulus
+  auto naive_modpow = [](const BigInt &b, const BigInt &e, const BigInt &m) {
+    BigInt result(1), base = b % m;
+    for (uint64_t i = e.get_bit_vector().size() * 64; i > 0; --i) {
+      result = (result * result) % m;
+      if (e.is_bit_set(i - 1)) {
+        result = (result * base) % m;
+      }
+    }
+    return result % m;
+  };
+  size_t sizes[] = { 1, 2, 5, 33 };
+  for (size_t n : sizes) {
+    std::vector<uint64_t> m_limbs = random_limbs(n, n);
+    for (int parity = 0; parity < 2; ++parity) {
+      m_limbs[0] = (m_limbs[0] & ~1UL) | parity;
+      BigInt m = from_limbs(m_limbs);
+      BigInt b = from_limbs(random_limbs(n + parity * 3, n + 100));
+      BigInt e = from_limbs(random_limbs(n < 5 ? n : 1, n + 200));
+      ASSERT(b.modpow(e, m) == naive_modpow(b, e, m));
+    }
+  }
+
+  // Fermat's little theorem, with the Mersenne primes 2^127 - 1 and
+  // 2^521 - 1 and exponents long enough for the widest windows
+  BigInt p127 = (BigInt(1) << 127) - BigInt(1);
+  BigInt p521 = (BigInt(1) << 521) - BigInt(1);
+  BigInt a = from_limbs(random_limbs(12, 7));
+  ASSERT(a.modpow(p127 - BigInt(1), p127) == BigInt(1));
+  ASSERT(a.modpow(p521 - BigInt(1), p521) == BigInt(1));
+  ASSERT(a.modpow(p521, p521) == a % p521);
+
+  try {
+    objs->three.modpow(objs->negative_three, objs->nine);
+    FAIL("modpow with a negative exponent should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    objs->three.modpow(objs->two, objs->zero);
+    FAIL("modpow with a zero modulus should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    objs->three.modpow(objs->two, objs->negative_three);
+    FAIL("modpow with a negative modulus should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_mod_context(TestObjs *objs) {
+  BigIntModContext ctx9(objs->nine);
+  ASSERT(ctx9.modulus() == objs->nine);
+  ASSERT(ctx9.reduce(BigInt(100)) == BigInt(1));
+  ASSERT(ctx9.reduce(objs->negative_three) == BigInt(6));
+  ASSERT(ctx9.reduce(BigInt(18, true)) == BigInt(0));
+  ASSERT(ctx9.mulmod(BigInt(7), BigInt(8)) == BigInt(2));
+  ASSERT(ctx9.addmod(BigInt(7), BigInt(8)) == BigInt(6));
+  ASSERT(ctx9.submod(objs->three, BigInt(8)) == BigInt(4));
+  ASSERT(ctx9.mulmod(objs->negative_three, BigInt(4)) == BigInt(6));
+
+  BigIntModContext ctx1(objs->one);
+  ASSERT(ctx1.reduce(objs->two_pow_64) == BigInt(0));
+  ASSERT(ctx1.mulmod(objs->three, objs->nine) == BigInt(0));
+
+  // agree with division for values of up to four times the length of
+  // the modulus, for moduli needing the largest normalizing shift
+  // (powers of 2^64) and none at all (all ones), and for moduli long
+  // enough to use recursive division; the second pass reduces with
+  // Barrett reduction at every size
+  size_t saved_barrett = mod_barrett_threshold;
+  for (size_t barrett : { saved_barrett, (size_t) 1 }) {
+    mod_barrett_threshold = barrett;
+    for (size_t n = 1; n <= 66; n += 13) {
+      BigInt moduli[] = {
+        from_limbs(random_limbs(n, n)),
+        BigInt(1) << (64 * (n - 1)),
+        (BigInt(1) << (64 * n)) - BigInt(1),
+      };
+      for (const BigInt &m : moduli) {
+        BigIntModContext ctx(m);
+        for (size_t xn = 1; xn <= 4 * n + 1; xn += n) {
+          BigInt x = from_limbs(random_limbs(xn, xn + n));
+          BigInt r = x % m;
+          ASSERT(ctx.reduce(x) == r);
+          ASSERT(ctx.reduce(-x) == (r == objs->zero ? r : m - r));
+        }
+        BigInt a = from_limbs(random_limbs(n, 2 * n)) % m;
+        BigInt b = from_limbs(random_limbs(n, 3 * n)) % m;
+        ASSERT(ctx.mulmod(a, b) == (a * b) % m);
+        ASSERT(ctx.mulmod(m - BigInt(1), m - BigInt(1)) == (m == objs->one ? BigInt(0) : BigInt(1)));
+        ASSERT(ctx.addmod(a, b) == (a + b) % m);
+        ASSERT(ctx.submod(a, b) == ctx.reduce(a - b));
+        ASSERT(ctx.submod(b, a) == ctx.reduce(b - a));
+      }
+    }
+  }
+  mod_barrett_threshold = saved_barrett;
+
+  try {
+    BigIntModContext bad(objs->zero);
+    FAIL("a context with a zero modulus should not be created");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    BigIntModContext bad(objs->negative_three);
+    FAIL("a context with a negative modulus should not be created");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_gcd(TestObjs *objs) {
+  ASSERT(BigInt(12).gcd(BigInt(18)) == BigInt(6));
+  ASSERT(BigInt(12, true).gcd(BigInt(18)) == BigInt(6));
+  ASSERT(objs->zero.gcd(objs->nine) == objs->nine);
+  ASSERT(objs->negative_three.gcd(objs->zero) == objs->three);
+  ASSERT(objs->zero.gcd(objs->zero) == objs->zero);
+  ASSERT((objs->two_pow_64 << 6).gcd(objs->two_pow_64 * objs->three) == objs->two_pow_64);
+
+  BigInt s, t;
+  ASSERT(BigInt(240).xgcd(BigInt(46), s, t) == objs->two);
+  ASSERT(s * BigInt(240) + t * BigInt(46) == objs->two);
+  ASSERT(objs->zero.xgcd(objs->negative_three, s, t) == objs->three);
+  ASSERT(t * objs->negative_three == objs->three);
+
+  // For random operands with a known common factor, g divides both and
+  // s*a + t*b == g, which proves that g is the greatest common divisor.
+  // The sizes cover the 128-bit finish, Lehmer steps and unequal
+  // lengths; the half-GCD recursion is exercised with low thresholds
+  // that make it recurse deeply.
+  struct { size_t an, bn, cn; } cases[] = {
+    { 1, 1, 0 }, { 2, 1, 1 }, { 3, 2, 0 }, { 10, 10, 3 }, { 40, 7, 2 },
+    { 60, 60, 5 }, { 300, 300, 20 }, { 310, 150, 1 }, { 400, 390, 40 },
+  };
+  size_t saved_dc = gcd_dc_threshold, saved_hgcd = gcd_hgcd_threshold;
+  for (int low_threshold = 0; low_threshold < 2; ++low_threshold) {
+    gcd_dc_threshold = low_threshold ? 20 : saved_dc;
+    gcd_hgcd_threshold = low_threshold ? 6 : saved_hgcd;
+    for (auto &c : cases) {
+      BigInt factor = c.cn ? from_limbs(random_limbs(c.cn, c.cn)) : objs->one;
+      BigInt a = factor * from_limbs(random_limbs(c.an, c.an + 1000));
+      BigInt b = factor * from_limbs(random_limbs(c.bn, c.bn + 2000), true);
+      BigInt g = a.xgcd(b, s, t);
+      ASSERT(g == a.gcd(b));
+      ASSERT(g == b.gcd(a));
+      ASSERT(g % factor == objs->zero);
+      ASSERT(a % g == objs->zero);
+      ASSERT(b % g == objs->zero);
+      ASSERT(s * a + t * b == g);
+    }
+  }
+  gcd_dc_threshold = saved_dc;
+  gcd_hgcd_threshold = saved_hgcd;
+
+  // consecutive Fibonacci numbers below 2^127 take the most steps in
+  // the 128-bit finish, and give cofactors of nearly 126 bits
+  BigInt f0 = objs->zero, f1 = objs->one;
+  while (f1.get_bits(1) >> 62 == 0) {
+    BigInt f2 = f0 + f1;
+    f0 = std::move(f1);
+    f1 = std::move(f2);
+  }
+  ASSERT(f1.xgcd(f0, s, t) == objs->one);
+  ASSERT(s * f1 + t * f0 == objs->one);
+
+  // modular inverses
+  ASSERT(objs->three.modinv(BigInt(10)) == BigInt(7));
+  ASSERT(objs->negative_three.modinv(BigInt(10)) == objs->three);
+  ASSERT(objs->three.modinv(objs->one) == objs->zero);
+  BigInt p521 = (BigInt(1) << 521) - BigInt(1);
+  BigInt x = from_limbs(random_limbs(20, 9));
+  BigInt inv = x.modinv(p521);
+  ASSERT(inv < p521);
+  ASSERT((x * inv) % p521 == objs->one);
+
+  try {
+    objs->three.modinv(objs->nine);
+    FAIL("modinv of a value not coprime to the modulus should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    objs->three.modinv(objs->zero);
+    FAIL("modinv with a zero modulus should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_isqrt(TestObjs *objs) {
+  ASSERT(objs->zero.isqrt() == objs->zero);
+  ASSERT(objs->one.isqrt() == objs->one);
+  ASSERT(objs->three.isqrt() == objs->one);
+  ASSERT(objs->nine.isqrt() == objs->three);
+  ASSERT(objs->two_pow_64.isqrt() == BigInt(1UL << 32));
+  ASSERT(BigInt(26).iroot(3) == objs->two);
+  ASSERT(BigInt(27).iroot(3) == objs->three);
+  ASSERT(BigInt(27, true).iroot(3) == objs->negative_three);
+  ASSERT(BigInt(26, true).iroot(3) == BigInt(2, true));
+  ASSERT(objs->nine.iroot(1) == objs->nine);
+  ASSERT(objs->two_pow_64.iroot(64) == objs->two);
+  ASSERT(objs->two_pow_64.iroot(65) == objs->one);
+  // roots of a degree above the bit length are 1 (or -1, or 0), and
+  // come back without computing 2^k
+  ASSERT(BigInt(5).iroot(1u << 30) == objs->one);
+  ASSERT(BigInt(5, true).iroot((1u << 30) + 1) == BigInt(1, true));
+  ASSERT(objs->u64_max.iroot(UINT32_MAX) == objs->one);
+  ASSERT(objs->zero.iroot(1u << 30) == objs->zero);
+
+  // r is the root of r^k - 1, r^k and r^k + 1 exactly when it is the
+  // root of the middle one only
+  for (unsigned k = 2; k <= 7; ++k) {
+    for (size_t n : { 1, 2, 3, 10, 70, 300 }) {
+      BigInt r = from_limbs(random_limbs(n, n + k));
+      BigInt rk = r;
+      for (unsigned i = 1; i < k; ++i) {
+        rk *= r;
+      }
+      BigInt below = rk - objs->one, above = rk + objs->one;
+      ASSERT(below.iroot(k) == r - objs->one);
+      ASSERT(rk.iroot(k) == r);
+      ASSERT(above.iroot(k) == r);
+      if (k == 2) {
+        ASSERT(below.isqrt() == r - objs->one);
+        ASSERT(rk.isqrt() == r);
+        ASSERT(rk.is_perfect_square());
+        ASSERT(!above.is_perfect_square());
+        ASSERT(!below.is_perfect_square());
+      }
+    }
+  }
+
+  // roots of random values satisfy r^2 <= n < (r+1)^2
+  for (size_t n : { 1, 5, 33, 500, 700 }) {
+    BigInt x = from_limbs(random_limbs(n, 3 * n));
+    BigInt r = x.isqrt();
+    ASSERT(r * r <= x);
+    ASSERT((r + objs->one) * (r + objs->one) > x);
+    r = x.iroot(5);
+    BigInt r5 = r * r * r * r * r;
+    BigInt s5 = (r + objs->one) * (r + objs->one) * (r + objs->one) * (r + objs->one) * (r + objs->one);
+    ASSERT(r5 <= x);
+    ASSERT(s5 > x);
+  }
+
+  ASSERT(objs->zero.is_perfect_square());
+  ASSERT(objs->nine.is_perfect_square());
+  ASSERT(!objs->three.is_perfect_square());
+  ASSERT(!objs->negative_nine.is_perfect_square());
+
+  try {
+    objs->negative_three.isqrt();
+    FAIL("isqrt of a negative value should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    objs->nine.iroot(0);
+    FAIL("zeroth root should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    objs->negative_nine.iroot(4);
+    FAIL("even root of a negative value should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_rshift(TestObjs *objs) {
+  BigInt result1 = BigInt({0x123456789abcdef0UL, 0xfedcba9876543210UL, 0x1UL}) >> 68;
+  check_contents(result1, { 0x1fedcba987654321UL });
+  ASSERT((objs->nine >> 0) == objs->nine);
+  ASSERT((objs->nine >> 64) == objs->zero);
+  ASSERT((objs->negative_nine >> 1).to_dec() == "-5");
+  ASSERT((objs->negative_nine >> 100).to_dec() == "-1");
+  ASSERT((objs->negative_two_pow_64 >> 64).to_dec() == "-1");
+  ASSERT(((objs->two_pow_64 + objs->one) >> 1) == BigInt(1UL << 63));
+
+  // division by a power of two truncates, while the shift rounds down;
+  // they agree for non-negative values
+  for (unsigned n : { 0, 1, 63, 64, 65, 200, 2000 }) {
+    BigInt d = objs->one << n;
+    for (bool neg : { false, true }) {
+      BigInt a = from_limbs(random_limbs(20, n), neg);
+      BigInt q = a / d, r = a % d;
+      ASSERT(q * d + r == a);
+      ASSERT(r.is_negative() == (neg && r != objs->zero));
+      ASSERT((neg ? -r : r) < d);
+      ASSERT((a >> n) == (r.is_negative() ? q - objs->one : q));
+      ASSERT(a / -d == -q);
+    }
+  }
+}
+
+void test_bitwise(TestObjs *objs) {
+  check_contents(BigInt({0xff00ff00ff00ff00UL, 0xf0f0UL}) & BigInt({0x0ff00ff00ff00ff0UL, 0xffUL}),
+                 { 0x0f000f000f000f00UL, 0xf0UL });
+  check_contents(BigInt({0xff00ff00ff00ff00UL, 0xf0f0UL}) | BigInt(0x0ff0UL),
+                 { 0xff00ff00ff00fff0UL, 0xf0f0UL });
+  check_contents(BigInt({0xff00ff00ff00ff00UL, 0xf0f0UL}) ^ BigInt({0xffffffffffffffffUL, 0xf0f0UL}),
+                 { 0x00ff00ff00ff00ffUL });
+  ASSERT((objs->nine & objs->nine) == objs->nine);
+  ASSERT((objs->nine ^ objs->nine) == objs->zero);
+  ASSERT((~objs->zero).to_dec() == "-1");
+  ASSERT(~objs->negative_nine == BigInt(8));
+
+  // small values agree with the two's complement operations on int64_t
+  for (int64_t a = -70; a <= 70; a += 3) {
+    for (int64_t b = -70; b <= 70; b += 5) {
+      BigInt x((uint64_t) (a < 0 ? -a : a), a < 0), y((uint64_t) (b < 0 ? -b : b), b < 0);
+      ASSERT((x & y).to_dec() == std::to_string(a & b));
+      ASSERT((x | y).to_dec() == std::to_string(a | b));
+      ASSERT((x ^ y).to_dec() == std::to_string(a ^ b));
+      ASSERT((~x).to_dec() == std::to_string(~a));
+    }
+  }
+
+  // carries of the two's complement conversions across limbs
+  ASSERT((objs->negative_two_pow_64 & objs->negative_two_pow_64) == objs->negative_two_pow_64);
+  ASSERT((objs->negative_two_pow_64 | objs->one) == objs->negative_two_pow_64 + objs->one);
+  ASSERT((objs->negative_two_pow_64 & (objs->two_pow_64 << 1)) == objs->two_pow_64 << 1);
+  ASSERT((BigInt(1UL << 63, true) ^ BigInt(1UL << 63)) == objs->negative_two_pow_64);
+
+  // identities on large operands of either sign and different lengths
+  for (size_t an : { 1, 3, 40 }) {
+    for (size_t bn : { 1, 2, 41 }) {
+      for (int signs = 0; signs < 4; ++signs) {
+        BigInt a = from_limbs(random_limbs(an, an), signs & 1);
+        BigInt b = from_limbs(random_limbs(bn, bn + 100), signs & 2);
+        BigInt and_ab = a & b, or_ab = a | b, xor_ab = a ^ b;
+        ASSERT(and_ab + or_ab == a + b);
+        ASSERT(or_ab - and_ab == xor_ab);
+        ASSERT((b & a) == and_ab);
+        ASSERT((xor_ab ^ b) == a);
+        ASSERT((a & ~a) == objs->zero);
+        ASSERT(~~a == a);
+        ASSERT((~(a & b)) == (~a | ~b));
+        for (unsigned bit = 0; bit < 64 * (an + bn); bit += 37) {
+          BigInt mask = objs->one << bit;
+          ASSERT(((a & mask) != objs->zero) == ((a >> bit) & objs->one).is_bit_set(0));
+        }
+
+        BigInt in_place = a;
+        in_place &= b;
+        ASSERT(in_place == and_ab);
+        in_place = a;
+        in_place |= b;
+        ASSERT(in_place == or_ab);
+        in_place = a;
+        in_place ^= b;
+        ASSERT(in_place == xor_ab);
+        in_place ^= in_place;
+        ASSERT(in_place == objs->zero);
+      }
+    }
+  }
+
+  // x & -x isolates the lowest set bit
+  BigInt x = from_limbs(random_limbs(5, 1)) << 200;
+  ASSERT((x & -x) == objs->one << (192 + __builtin_ctzll(x.get_bits(3))));
+
+  // results of other operators as operands
+  ASSERT(((objs->nine + objs->three) & objs->nine) == BigInt(8));
+  ASSERT((objs->three | objs->nine * objs->three) == BigInt(27));
+  ASSERT(((objs->nine * objs->nine) >> 2) == BigInt(20));
+  ASSERT(~(objs->nine - objs->three) == BigInt(7, true));
+}
+
+void test_square(TestObjs *objs) {
+  // squares in every tier, checked against the schoolbook product; the
+  // sizes cover every remainder mod 3 in the Toom-3 range
+
+  ASSERT(objs->zero.square() == objs->zero);
+  ASSERT(objs->negative_three.square() == objs->nine);
+  check_contents(BigInt(0xFFFFFFFFFFFFFFFFUL).square(), { 1UL, 0xFFFFFFFFFFFFFFFEUL });
+
+  size_t sizes[] = { 1, 2, 3, 7, sqr_karatsuba_threshold, sqr_karatsuba_threshold + 1,
+                     3 * sqr_karatsuba_threshold + 7, sqr_toom3_threshold,
+                     sqr_toom3_threshold + 1, sqr_toom3_threshold + 2 };
+  for (size_t n : sizes) {
+    std::vector<uint64_t> a = random_limbs(n, 7 * n);
+    BigInt x = from_limbs(a, true), y = from_limbs(a);
+    BigInt expected = schoolbook_product(a, a);
+    ASSERT(x.square() == expected);
+    ASSERT(x * x == expected);
+    ASSERT(x * y == -expected);
+
+    BigInt in_place = x;
+    in_place *= y;
+    ASSERT(in_place == -expected);
+    in_place = x;
+    in_place *= in_place;
+    ASSERT(in_place == expected);
+  }
+
+  // with tiny thresholds, small operands recurse through every tier,
+  // including the transform; all-ones limbs exercise every carry
+  size_t saved_karatsuba = sqr_karatsuba_threshold;
+  size_t saved_toom3 = sqr_toom3_threshold;
+  size_t saved_ntt = mul_ntt_threshold;
+  sqr_karatsuba_threshold = 1;
+  sqr_toom3_threshold = 9;
+  bool all_match = true;
+  for (size_t ntt : { saved_ntt, (size_t) 40 }) {
+    mul_ntt_threshold = ntt;
+    for (size_t n = 1; n < 80; ++n) {
+      std::vector<uint64_t> a = random_limbs(n, n + 11);
+      std::vector<uint64_t> ones(n, 0xFFFFFFFFFFFFFFFFUL);
+      all_match = all_match && from_limbs(a).square() == schoolbook_product(a, a);
+      all_match = all_match && from_limbs(ones).square() == schoolbook_product(ones, ones);
+    }
+  }
+  sqr_karatsuba_threshold = saved_karatsuba;
+  sqr_toom3_threshold = saved_toom3;
+  mul_ntt_threshold = saved_ntt;
+  ASSERT(all_match);
+}
+
+void test_pow(TestObjs *objs) {
+  ASSERT(objs->zero.pow(0) == objs->one);
+  ASSERT(objs->zero.pow(5) == objs->zero);
+  ASSERT(objs->nine.pow(0) == objs->one);
+  ASSERT(objs->nine.pow(1) == objs->nine);
+  ASSERT(objs->one.pow(1UL << 40) == objs->one);
+  ASSERT(BigInt(1, true).pow(1UL << 40) == objs->one);
+  ASSERT(BigInt(1, true).pow((1UL << 40) + 1) == BigInt(1, true));
+  ASSERT(objs->three.pow(4) == BigInt(81));
+  ASSERT(objs->negative_three.pow(3) == BigInt(27, true));
+  ASSERT(objs->negative_three.pow(4) == BigInt(81));
+  ASSERT(objs->two.pow(64) == objs->two_pow_64);
+  ASSERT(BigInt(10).pow(19).to_dec() == "10000000000000000000");
+  ASSERT(BigInt(2, true).pow(1001) == -(objs->one << 1001));
+  ASSERT(BigInt(96).pow(3) == BigInt(884736));
+
+  // against repeated multiplication, for single- and multi-limb odd
+  // parts with and without trailing zero bits
+  BigInt bases[] = {
+    BigInt(10), BigInt(3), BigInt(12345678901234567UL, true),
+    from_limbs(random_limbs(3, 1)), -(from_limbs(random_limbs(2, 2)) << 100),
+  };
+  for (const BigInt &base : bases) {
+    BigInt expected = objs->one;
+    for (uint64_t e = 0; e <= 70; ++e) {
+      ASSERT(base.pow(e) == expected);
+      expected *= base;
+    }
+  }
+
+  // power of two exponents are repeated squares
+  BigInt x = from_limbs(random_limbs(4, 4));
+  BigInt squares = x;
+  for (uint64_t e = 2; e <= 256; e *= 2) {
+    squares = squares.square();
+    ASSERT(x.pow(e) == squares);
+  }
+
+  try {
+    objs->two.pow(1UL << 40);
+    FAIL("a power too large to represent should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    objs->three.pow(UINT64_MAX);
+    FAIL("a power too large to represent should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_factorial(TestObjs *objs) {
+  ASSERT(BigInt::factorial(0) == objs->one);
+  ASSERT(BigInt::factorial(1) == objs->one);
+  ASSERT(BigInt::factorial(5) == BigInt(120));
+  ASSERT(BigInt::factorial(20) == BigInt(2432902008176640000UL));
+  ASSERT(BigInt::factorial(25).to_dec() == "15511210043330985984000000");
+
+  // against the running product, across the recursion's base case and
+  // many prime swings
+  BigInt expected = objs->one;
+  for (uint64_t n = 1; n <= 600; ++n) {
+    expected *= BigInt(n);
+    if (n % 7 == 0 || n < 30) {
+      ASSERT(BigInt::factorial(n) == expected);
+    }
+  }
+
+  ASSERT(BigInt::binomial(0, 0) == objs->one);
+  ASSERT(BigInt::binomial(5, 6) == objs->zero);
+  ASSERT(BigInt::binomial(10, 3) == BigInt(120));
+  ASSERT(BigInt::binomial(10, 7) == BigInt(120));
+  ASSERT(BigInt::binomial(UINT64_MAX, 1) == BigInt(UINT64_MAX));
+  ASSERT(BigInt::binomial(UINT64_MAX, UINT64_MAX) == objs->one);
+  ASSERT(BigInt::binomial(100, 50).to_dec() == "100891344545564193334812497256");
+
+  // Pascal's rule, over both the prime factorization and the product
+  // formula
+  for (uint64_t n : { 30, 200, 2001 }) {
+    for (uint64_t k : { 1, 2, 3, 17, 40, 99, 100 }) {
+      if (k <= n) {
+        ASSERT(BigInt::binomial(n + 1, k + 1) == BigInt::binomial(n, k) + BigInt::binomial(n, k + 1));
+      }
+    }
+  }
+  ASSERT(BigInt::binomial(3000, 1500) * BigInt::factorial(1500).square() == BigInt::factorial(3000));
+
+  try {
+    BigInt::factorial(1UL << 32);
+    FAIL("a factorial too large to represent should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    BigInt::binomial(1UL << 40, 1UL << 39);
+    FAIL("a binomial coefficient too large to represent should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_is_prime(TestObjs *objs) {
+  ASSERT(!objs->zero.is_probable_prime());
+  ASSERT(!objs->one.is_probable_prime());
+  ASSERT(objs->two.is_probable_prime());
+  ASSERT(objs->three.is_probable_prime());
+  ASSERT(!objs->nine.is_probable_prime());
+  ASSERT(!objs->negative_three.is_probable_prime());
+  ASSERT(!objs->two_pow_64.is_probable_prime());
+
+  // agreement with a sieve, on both sides of the trial division bound
+  const uint64_t limit = 20000;
+  std::vector<bool> composite(limit + 1);
+  composite[0] = composite[1] = true;
+  for (uint64_t p = 2; p * p <= limit; ++p) {
+    for (uint64_t j = p * p; !composite[p] && j <= limit; j += p) {
+      composite[j] = true;
+    }
+  }
+  for (uint64_t n = 0; n <= limit; ++n) {
+    ASSERT(BigInt(n).is_probable_prime() == !composite[n]);
+  }
+  for (uint64_t n = 0; n < limit - 100; n += 3) {
+    uint64_t next = n + 1;
+    while (composite[next]) {
+      ++next;
+    }
+    ASSERT(BigInt(n).next_prime() == BigInt(next));
+  }
+  ASSERT(objs->zero.next_prime() == objs->two);
+  ASSERT(objs->negative_nine.next_prime() == objs->two);
+
+  // strong pseudoprimes to base 2, and to several other bases
+  for (uint64_t n : { 3215031751UL, 2152302898747UL, 3474749660383UL, 341550071728321UL,
+                      3825123056546413051UL }) {
+    ASSERT(!BigInt(n).is_probable_prime());
+    ASSERT(!BigInt(n).is_probable_prime(5));
+  }
+  ASSERT(BigInt(18446744073709551557UL).is_probable_prime());
+  ASSERT(objs->two_pow_64.next_prime() == (BigInt(1) << 64) + BigInt(13));
+
+  BigInt m127 = (BigInt(1) << 127) - BigInt(1);
+  BigInt m521 = (BigInt(1) << 521) - BigInt(1);
+  ASSERT(m127.is_probable_prime());
+  ASSERT(m521.is_probable_prime(3));
+  ASSERT(!(m127 + BigInt(2)).is_probable_prime());
+  ASSERT(!(m127 * m521).is_probable_prime());
+  ASSERT(!(m127 * m127).is_probable_prime());
+  ASSERT((m127 - BigInt(24)).next_prime() == m127);
+  BigInt after = m521.next_prime();
+  ASSERT(after > m521);
+  ASSERT(after.is_probable_prime());
+}
+
+template <unsigned Bits>
+void check_fixed_int(uint64_t seed) {
+  typedef FixedInt<Bits> F;
+  BigInt mask = (BigInt(1) << Bits) - BigInt(1);
+  std::vector<uint64_t> la = random_limbs(F::LIMBS, seed);
+  std::vector<uint64_t> lb = random_limbs(F::LIMBS, seed + 1);
+  if (seed % 3 == 1) {
+    lb[0] = 0; // b shorter than a, and a carry chain through zeros
+    lb.back() = 0;
+  } else if (seed % 3 == 2) {
+    lb = la;
+    lb[0] ^= 1; // operands differing in the lowest bit only
+  }
+  BigInt a = from_limbs(la), b = from_limbs(lb);
+  F fa(a), fb(b);
+
+  ASSERT(fa.to_bigint() == a);
+  ASSERT(fb.to_bigint() == b);
+  ASSERT((fa + fb).to_bigint() == ((a + b) & mask));
+  ASSERT((fa - fb).to_bigint() == ((a - b) & mask));
+  ASSERT((fb - fa).to_bigint() == ((b - a) & mask));
+  ASSERT((-fa).to_bigint() == BigInt(-a & mask));
+  ASSERT((fa * fb).to_bigint() == ((a * b) & mask));
+  ASSERT(fa.mul_wide(fb).to_bigint() == a * b);
+  ASSERT((fa & fb).to_bigint() == (a & b));
+  ASSERT((fa | fb).to_bigint() == (a | b));
+  ASSERT((fa ^ fb).to_bigint() == (a ^ b));
+  ASSERT((~fa).to_bigint() == BigInt(~a & mask));
+  for (unsigned n : { 0U, 1U, 63U, 64U, 65U, 127U, Bits - 1, Bits, Bits + 70 }) {
+    ASSERT((fa << n).to_bigint() == ((a << n) & mask));
+    ASSERT((fa >> n).to_bigint() == (a >> n));
+    ASSERT(fa.is_bit_set(n) == a.is_bit_set(n));
+  }
+  ASSERT(fa.compare(fb) == a.compare(b));
+  ASSERT(fb.compare(fa) == b.compare(a));
+  ASSERT(fa.compare(fa) == 0);
+  ASSERT((fa < fb) == (a < b));
+  if (!fb.is_zero()) {
+    ASSERT((fa / fb).to_bigint() == a / b);
+    ASSERT((fa % fb).to_bigint() == a % b);
+  }
+  ASSERT((fb / ((fa >> 70) + F(3))).to_bigint() == b / BigInt((a >> 70) + BigInt(3)));
+  ASSERT((fa % F(1000)).to_bigint() == a % BigInt(1000));
+
+  F acc = fa;
+  acc += fb;
+  acc *= fa;
+  acc -= fb;
+  acc <<= 3;
+  acc ^= fa;
+  ASSERT(acc.to_bigint() == ((((((a + b) * a - b) & mask) << 3) & mask) ^ a));
+}
+
+void test_fixed_int(TestObjs *) {
+  // everything but the conversions works at compile time
+  constexpr FixedInt<128> max64(UINT64_MAX);
+  static_assert(max64 + FixedInt<128>(1) == FixedInt<128>({ 0, 1 }), "carry into the second limb");
+  static_assert(FixedInt<128>() - FixedInt<128>(1) == FixedInt<128>({ UINT64_MAX, UINT64_MAX }), "wraparound");
+  static_assert(max64 * max64 == FixedInt<128>({ 1, UINT64_MAX - 1 }), "product");
+  static_assert(FixedInt<128>({ 0, 1 }) * FixedInt<128>({ 0, 1 }) == FixedInt<128>(), "product modulo 2^128");
+  static_assert(FixedInt<128>({ 0, 1 }).mul_wide(FixedInt<128>({ 0, 1 })) == FixedInt<256>({ 0, 0, 1 }),
+                "wide product");
+  static_assert(((FixedInt<256>(5) << 254) >> 254) == FixedInt<256>(1), "shifts");
+  static_assert(FixedInt<256>(1) << 256 == FixedInt<256>(), "shift past the top");
+  static_assert(FixedInt<512>({ 0, 0, 0, 1 }) > FixedInt<512>({ UINT64_MAX, UINT64_MAX, UINT64_MAX }), "compare");
+  static_assert(FixedInt<64>(6).is_bit_set(2) && !FixedInt<64>(6).is_bit_set(64), "bits");
+  static_assert(sizeof(FixedInt<256>) == 32, "no storage beyond the limbs");
+
+  for (uint64_t seed = 1; seed <= 30; ++seed) {
+    check_fixed_int<64>(seed);
+    check_fixed_int<128>(seed);
+    check_fixed_int<256>(seed);
+    check_fixed_int<512>(seed);
+  }
+
+  ASSERT(FixedInt<256>(BigInt()).is_zero());
+  ASSERT(FixedInt<128>().to_bigint() == BigInt());
+  try {
+    FixedInt<128> x(BigInt(1) << 128);
+    FAIL("a value wider than the FixedInt should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    FixedInt<128> x(BigInt(1, true));
+    FAIL("a negative value should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    FixedInt<64> x({ 1, 2 });
+    FAIL("too many limbs should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
+
+void test_big_literal(TestObjs *) {
+  // literals get the fewest limbs that hold them
+  static_assert(std::is_same<decltype(0_big), FixedInt<64>>::value, "0 fits in one limb");
+  static_assert(std::is_same<decltype(18446744073709551615_big), FixedInt<64>>::value, "2^64 - 1");
+  static_assert(std::is_same<decltype(18446744073709551616_big), FixedInt<128>>::value, "2^64");
+  static_assert(0_big == FixedInt<64>(), "zero");
+  static_assert(18446744073709551616_big == FixedInt<128>({ 0, 1 }), "decimal");
+  static_assert(0x1'0000'0000'0000'0000_big == FixedInt<128>({ 0, 1 }), "hexadecimal with separators");
+  static_assert(0XfFfF_big == FixedInt<64>(65535), "hexadecimal digits in either case");
+  static_assert(0b1011_big == FixedInt<64>(11), "binary");
+  static_assert(0777_big == FixedInt<64>(511), "octal");
+
+  // constants computed at compile time from literals: the prime
+  // 2^128 - 159, and 2^256 mod it
+  constexpr FixedInt<128> p = 340282366920938463463374607431768211297_big;
+  static_assert(p == (FixedInt<128>() - FixedInt<128>(159)), "2^128 - 159");
+  constexpr FixedInt<256> r = (FixedInt<256>() - p) % p;
+  static_assert(r == FixedInt<256>(159 * 159), "2^256 mod p");
+  static_assert(p / 1000_big == 340282366920938463463374607431768211_big, "quotient");
+  static_assert(p % 1000_big == 297_big, "remainder");
+
+  // a table built into the binary, converted to BigInt where needed
+  static constexpr FixedInt<128> powers[] = { 1_big, 1000000000000000000000_big, 1000000000000000000000000000000_big };
+  ASSERT(BigInt(powers[2]) == BigInt(powers[1]) * BigInt(1000000000));
+
+  BigInt x(123456789012345678901234567890123456789012345678901234567890_big);
+  ASSERT(x == BigInt::from_dec("123456789012345678901234567890123456789012345678901234567890"));
+  ASSERT(x.to_hex() == "13aaf504e4bc1e62173f87a4378c37b49c8ccff196ce3f0ad2");
+
+  // operands of different widths are computed at the wider width,
+  // in either order
+  static_assert(std::is_same<decltype(2_big * p), FixedInt<128>>::value, "widened product");
+  static_assert(std::is_same<decltype(p * 2_big), FixedInt<128>>::value, "widened product");
+  static_assert(2_big * p == p * 2_big && 2_big * p == p + p, "mixed-width product");
+  static_assert(1_big - p == FixedInt<128>(160) && p - 1_big == p + ~FixedInt<128>(), "mixed-width difference");
+  static_assert(1_big < p && p > 1_big && 1_big != p, "mixed-width comparison");
+  static_assert((0xff_big & p) == 0x61_big && (p & 0xff_big) == 0x61_big, "mixed-width AND");
+  static_assert(p + 1 == 1 + p && p % 1000 == 297_big, "uint64_t operands");
+
+  // with a BigInt operand, a FixedInt converts and the result is a
+  // BigInt, in either order
+  BigInt y = BigInt::from_dec("-1000");
+  static_assert(std::is_same<decltype(5_big + y), BigInt>::value, "BigInt sum");
+  static_assert(std::is_same<decltype(y + 5_big), BigInt>::value, "BigInt sum");
+  ASSERT(5_big + y == BigInt(995, true) && y + 5_big == BigInt(995, true));
+  ASSERT(5_big - y == BigInt(1005) && y - 5_big == BigInt(1005, true));
+  ASSERT(p * y == y * p && p * y == BigInt(p) * y);
+  ASSERT(p / y == BigInt(p) / y && y / 7_big == BigInt(142, true));
+  ASSERT(p % y == 297_big && y % 7_big == BigInt(6, true));
+  ASSERT((p & y) == (y & p) && (p | y) == (y | p) && (p ^ y) == (y ^ p) && (p & y) == (BigInt(p) & y));
+  ASSERT(x + 1_big == BigInt::from_dec("123456789012345678901234567890123456789012345678901234567891"));
+  ASSERT(y < 5_big && 5_big > y && y <= 5_big && 5_big >= y && 5_big != y && !(y == 5_big));
+  ASSERT(1000_big == -y && -y == 1000_big);
+
+  // FixedInt arithmetic wraps around, so the conversion to BigInt is
+  // explicit: `BigInt b = -5_big;` does not compile
+  static_assert(!std::is_convertible<FixedInt<64>, BigInt>::value, "explicit conversion to BigInt");
+  static_assert(std::is_constructible<BigInt, FixedInt<64>>::value, "explicit conversion to BigInt");
+  ASSERT(-BigInt(5_big) == BigInt(5, true));
+  ASSERT(BigInt(-5_big) == BigInt(UINT64_MAX - 4));
+
+  ASSERT(FixedInt<64>(FixedInt<128>({ 7, 9 })) == FixedInt<64>(7));
+  ASSERT(FixedInt<128>::from_literal("0x1'0000'0000'0000'0000") == FixedInt<128>({ 0, 1 }));
+  try {
+    FixedInt<64>::from_literal("18446744073709551616");
+    FAIL("a literal too large for the FixedInt should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    FixedInt<64>::from_literal("12a");
+    FAIL("an invalid decimal digit should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    FixedInt<64>::from_literal("");
+    FAIL("an empty literal should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+  try {
+    FixedInt<128>(1) / FixedInt<128>();
+    FAIL("division by zero should throw");
+  } catch (std::invalid_argument &ex) {
+    // good
+  }
+}
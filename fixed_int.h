@@ -0,0 +1,593 @@
+#ifndef FIXED_INT_H
+#define FIXED_INT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "bigint.h"
+
+//! @file
+//! Fixed-width unsigned integers, for values whose size is known at
+//! compile time (e.g., 128, 256 or 512 bits), and the `_big` literal
+//! suffix for integer constants of any size.
+
+//! Unsigned integer of `Bits` bits (a positive multiple of 64), stored
+//! as an array of `uint64_t` limbs inside the object, least significant
+//! first. Like the built-in unsigned types, arithmetic wraps around
+//! modulo `2^Bits`; `mul_wide` gives the full product. No operation
+//! allocates, and the loops of the arithmetic, bitwise and comparison
+//! operators run a number of times known at compile time, and are
+//! marked to be unrolled completely (which GCC does not do by itself
+//! at `-O2`), so that each operation compiles to straight-line code.
+//! Everything but the conversions from and to BigInt is `constexpr`. The
+//! conversions are explicit, and lossless: a FixedInt converts to the
+//! BigInt with the same value, and a BigInt converts to a FixedInt if
+//! it is non-negative and fits in `Bits` bits.
+//!
+//! The binary operators take operands of different widths, and compute
+//! at the wider one (a narrower FixedInt converts implicitly to a wider
+//! one, as does a `uint64_t`). With a FixedInt and a BigInt operand,
+//! the FixedInt is converted and the result is a BigInt.
+template <unsigned Bits>
+class FixedInt {
+  static_assert(Bits > 0 && Bits % 64 == 0, "FixedInt width must be a positive multiple of 64");
+
+  template <unsigned> friend class FixedInt;
+
+public:
+  //! Number of limbs in the representation.
+  static constexpr size_t LIMBS = Bits / 64;
+
+private:
+  typedef unsigned __int128 uint128_t;
+
+  std::array<uint64_t, LIMBS> limbs;
+
+  // Set this value to this * m + a, returning the limb carried out of
+  // the top.
+  constexpr uint64_t mul_add_1(uint64_t m, uint64_t a)
+  {
+    uint64_t carry = a;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint128_t t = (uint128_t) limbs[i] * m + carry;
+      limbs[i] = (uint64_t) t;
+      carry = (uint64_t) (t >> 64);
+    }
+    return carry;
+  }
+
+public:
+  //! Default constructor: the value is 0.
+  constexpr FixedInt() : limbs() { }
+
+  //! Constructor from a `uint64_t` value.
+  //!
+  //! @param val the value
+  constexpr FixedInt(uint64_t val) : limbs() { limbs[0] = val; }
+
+  //! Constructor from an `std::initializer_list` of `uint64_t` values,
+  //! in order from less-significant to more-significant, as for BigInt.
+  //! Missing limbs are 0.
+  //!
+  //! @param vals the limbs of the value
+  //! @throw std::invalid_argument if there are more than `LIMBS` values
+  constexpr FixedInt(std::initializer_list<uint64_t> vals) : limbs()
+  {
+    if (vals.size() > LIMBS) {
+      throw std::invalid_argument("too many limbs for FixedInt");
+    }
+    size_t i = 0;
+    for (uint64_t val : vals) {
+      limbs[i++] = val;
+    }
+  }
+
+  //! Widening conversion from a narrower FixedInt, which is lossless
+  //! (and therefore implicit).
+  //!
+  //! @param other the value
+  template <unsigned OtherBits, typename std::enable_if<(OtherBits < Bits), int>::type = 0>
+  constexpr FixedInt(const FixedInt<OtherBits> &other) : limbs()
+  {
+    for (size_t i = 0; i < other.LIMBS; ++i) {
+      limbs[i] = other.limbs[i];
+    }
+  }
+
+  //! Narrowing conversion from a wider FixedInt, which keeps the low
+  //! `Bits` bits (like a conversion between built-in unsigned types).
+  //!
+  //! @param other the value
+  template <unsigned OtherBits, typename std::enable_if<(OtherBits > Bits), int>::type = 0>
+  constexpr explicit FixedInt(const FixedInt<OtherBits> &other) : limbs()
+  {
+    for (size_t i = 0; i < LIMBS; ++i) {
+      limbs[i] = other.limbs[i];
+    }
+  }
+
+  //! Constructor from a BigInt value.
+  //!
+  //! @param val the value, which must be in the range `[0, 2^Bits)`
+  //! @throw std::invalid_argument if `val` is negative or does not fit
+  //!        in `Bits` bits
+  explicit FixedInt(const BigInt &val) : limbs()
+  {
+    LimbSpan v = val.get_bit_vector();
+    if (val.is_negative() || v.size() > LIMBS) {
+      throw std::invalid_argument("value out of range for FixedInt");
+    }
+    for (size_t i = 0; i < v.size(); ++i) {
+      limbs[i] = v[i];
+    }
+  }
+
+  //! Convert to a BigInt.
+  //!
+  //! @return the BigInt with the same value
+  BigInt to_bigint() const { return BigInt(LimbSpan(limbs.data(), LIMBS)); }
+
+  //! Conversion to a BigInt. This is explicit: the value is lossless,
+  //! but FixedInt arithmetic wraps around, so an implicit conversion
+  //! would let e.g. `BigInt b = -5_big;` silently produce `2^64 - 5`.
+  explicit operator BigInt() const { return to_bigint(); }
+
+  //! Parse an unsigned integer written as in C++ source: decimal,
+  //! hexadecimal with a `0x` or `0X` prefix, binary with `0b` or `0B`,
+  //! or octal with a leading `0`, optionally with `'` digit
+  //! separators. In a constant expression, an invalid string is a
+  //! compile-time error.
+  //!
+  //! @param str the digits
+  //! @return the value
+  //! @throw std::invalid_argument if `str` is not a valid integer, or
+  //!        its value does not fit in `Bits` bits
+  static constexpr FixedInt from_literal(std::string_view str)
+  {
+    unsigned base = 10;
+    size_t i = 0;
+    if (str.size() > 1 && str[0] == '0') {
+      if (str[1] == 'x' || str[1] == 'X') {
+        base = 16;
+        i = 2;
+      } else if (str[1] == 'b' || str[1] == 'B') {
+        base = 2;
+        i = 2;
+      } else {
+        base = 8;
+        i = 1;
+      }
+    }
+    if (i == str.size()) {
+      throw std::invalid_argument("invalid integer literal");
+    }
+
+    FixedInt result;
+    for (; i < str.size(); ++i) {
+      char c = str[i];
+      if (c == '\'') {
+        continue;
+      }
+      unsigned digit = base;
+      if (c >= '0' && c <= '9') {
+        digit = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        digit = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        digit = c - 'A' + 10;
+      }
+      if (digit >= base) {
+        throw std::invalid_argument("invalid integer literal");
+      }
+      if (result.mul_add_1(base, digit) != 0) {
+        throw std::invalid_argument("integer literal too large for FixedInt");
+      }
+    }
+    return result;
+  }
+
+  //! Number of bits in the value, not counting leading zeros.
+  //!
+  //! @return the position of the highest set bit plus one (0 for 0)
+  constexpr unsigned bit_length() const
+  {
+    for (size_t i = LIMBS; i > 0; --i) {
+      if (limbs[i - 1] != 0) {
+        return 64 * i - __builtin_clzll(limbs[i - 1]);
+      }
+    }
+    return 0;
+  }
+
+  //! Get one `uint64_t` chunk of the value, as for `BigInt::get_bits`.
+  //!
+  //! @param index the index of the limb (0 for the least significant
+  //!              64 bits, etc.)
+  //! @return the limb, or 0 if `index` is `LIMBS` or more
+  constexpr uint64_t get_bits(unsigned index) const { return index < LIMBS ? limbs[index] : 0; }
+
+  //! Test whether a specific bit is set to 1.
+  //!
+  //! @param n the bit to test (0 for the least significant bit, etc.)
+  //! @return true if bit `n` is set to 1, false if it is 0 (or `n` is
+  //!         `Bits` or more)
+  constexpr bool is_bit_set(unsigned n) const { return (get_bits(n / 64) >> (n % 64)) & 1; }
+
+  //! Check whether the value is 0.
+  //!
+  //! @return true if the value is 0
+  constexpr bool is_zero() const
+  {
+    uint64_t any = 0;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      any |= limbs[i];
+    }
+    return any == 0;
+  }
+
+  //! Addition modulo `2^Bits`.
+  //!
+  //! @param lhs the left-hand operand
+  //! @param rhs the right-hand operand
+  //! @return the sum, without the carry out of the top limb
+  friend constexpr FixedInt operator+(const FixedInt &lhs, const FixedInt &rhs)
+  {
+    FixedInt result;
+    uint64_t carry = 0;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint128_t sum = (uint128_t) lhs.limbs[i] + rhs.limbs[i] + carry;
+      result.limbs[i] = (uint64_t) sum;
+      carry = (uint64_t) (sum >> 64);
+    }
+    return result;
+  }
+
+  //! Subtraction modulo `2^Bits`.
+  //!
+  //! @param lhs the left-hand operand
+  //! @param rhs the right-hand operand
+  //! @return the difference, wrapped around if `rhs` is the larger
+  friend constexpr FixedInt operator-(const FixedInt &lhs, const FixedInt &rhs)
+  {
+    FixedInt result;
+    uint64_t borrow = 0;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint128_t diff = (uint128_t) lhs.limbs[i] - rhs.limbs[i] - borrow;
+      result.limbs[i] = (uint64_t) diff;
+      borrow = (uint64_t) (diff >> 64) & 1;
+    }
+    return result;
+  }
+
+  //! Negation modulo `2^Bits`.
+  //!
+  //! @return `2^Bits - x` (0 for 0)
+  constexpr FixedInt operator-() const { return FixedInt() - *this; }
+
+  //! Multiplication modulo `2^Bits`. Only the limb products that
+  //! contribute to the low `Bits` bits are computed.
+  //!
+  //! @param lhs the left-hand operand
+  //! @param rhs the right-hand operand
+  //! @return the low `Bits` bits of the product
+  friend constexpr FixedInt operator*(const FixedInt &lhs, const FixedInt &rhs)
+  {
+    FixedInt result;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint64_t carry = 0;
+      #pragma GCC unroll 64
+      for (size_t j = 0; i + j < LIMBS; ++j) {
+        uint128_t t = (uint128_t) lhs.limbs[i] * rhs.limbs[j] + result.limbs[i + j] + carry;
+        result.limbs[i + j] = (uint64_t) t;
+        carry = (uint64_t) (t >> 64);
+      }
+    }
+    return result;
+  }
+
+  //! Full product, twice as wide as the operands.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return the product
+  constexpr FixedInt<2 * Bits> mul_wide(const FixedInt &rhs) const
+  {
+    FixedInt<2 * Bits> result;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      uint64_t carry = 0;
+      #pragma GCC unroll 64
+      for (size_t j = 0; j < LIMBS; ++j) {
+        uint128_t t = (uint128_t) limbs[i] * rhs.limbs[j] + result.limbs[i + j] + carry;
+        result.limbs[i + j] = (uint64_t) t;
+        carry = (uint64_t) (t >> 64);
+      }
+      result.limbs[i + LIMBS] = carry;
+    }
+    return result;
+  }
+
+  //! Compute the quotient and the remainder of a division together.
+  //! This is binary long division, one quotient bit per step: cheap
+  //! enough for constants evaluated at compile time, but at run time,
+  //! BigInt division is much faster for all but the smallest widths.
+  //!
+  //! @param rhs the divisor
+  //! @return a pair whose first element is the quotient and whose
+  //!         second element is the remainder
+  //! @throw std::invalid_argument if `rhs` is 0
+  constexpr std::pair<FixedInt, FixedInt> divmod(const FixedInt &rhs) const
+  {
+    if (rhs.is_zero()) {
+      throw std::invalid_argument("division by zero");
+    }
+    FixedInt quotient, remainder;
+    for (unsigned i = bit_length(); i > 0; --i) {
+      // remainder < rhs, so the shifted remainder less rhs fits even
+      // when the shift carries out of the top
+      bool carry = remainder.is_bit_set(Bits - 1);
+      remainder <<= 1;
+      remainder.limbs[0] |= is_bit_set(i - 1);
+      if (carry || remainder >= rhs) {
+        remainder -= rhs;
+        quotient.limbs[(i - 1) / 64] |= (uint64_t) 1 << ((i - 1) % 64);
+      }
+    }
+    return std::pair<FixedInt, FixedInt>(quotient, remainder);
+  }
+
+  //! Division operator.
+  //!
+  //! @param lhs the dividend
+  //! @param rhs the divisor
+  //! @return the quotient, rounded down
+  //! @throw std::invalid_argument if `rhs` is 0
+  friend constexpr FixedInt operator/(const FixedInt &lhs, const FixedInt &rhs) { return lhs.divmod(rhs).first; }
+
+  //! Remainder operator.
+  //!
+  //! @param lhs the dividend
+  //! @param rhs the divisor
+  //! @return the remainder of the division by `rhs`
+  //! @throw std::invalid_argument if `rhs` is 0
+  friend constexpr FixedInt operator%(const FixedInt &lhs, const FixedInt &rhs) { return lhs.divmod(rhs).second; }
+
+  //! Left shift by n bits; bits shifted past the top are lost.
+  //!
+  //! @param n number of bits to shift left by
+  //! @return the shifted value (0 if `n` is `Bits` or more)
+  constexpr FixedInt operator<<(unsigned n) const
+  {
+    FixedInt result;
+    size_t skip = n / 64;
+    unsigned bit = n % 64;
+    for (size_t i = LIMBS; i > skip; --i) {
+      size_t src = i - 1 - skip;
+      uint64_t limb = limbs[src] << bit;
+      if (bit != 0 && src > 0) {
+        limb |= limbs[src - 1] >> (64 - bit);
+      }
+      result.limbs[i - 1] = limb;
+    }
+    return result;
+  }
+
+  //! Right shift by n bits.
+  //!
+  //! @param n number of bits to shift right by
+  //! @return the shifted value (0 if `n` is `Bits` or more)
+  constexpr FixedInt operator>>(unsigned n) const
+  {
+    FixedInt result;
+    size_t skip = n / 64;
+    unsigned bit = n % 64;
+    for (size_t i = 0; i + skip < LIMBS; ++i) {
+      size_t src = i + skip;
+      uint64_t limb = limbs[src] >> bit;
+      if (bit != 0 && src + 1 < LIMBS) {
+        limb |= limbs[src + 1] << (64 - bit);
+      }
+      result.limbs[i] = limb;
+    }
+    return result;
+  }
+
+  //! Bitwise AND operator.
+  //!
+  //! @param lhs the left-hand operand
+  //! @param rhs the right-hand operand
+  //! @return the bitwise AND of the operands
+  friend constexpr FixedInt operator&(const FixedInt &lhs, const FixedInt &rhs)
+  {
+    FixedInt result;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      result.limbs[i] = lhs.limbs[i] & rhs.limbs[i];
+    }
+    return result;
+  }
+
+  //! Bitwise OR operator.
+  //!
+  //! @param lhs the left-hand operand
+  //! @param rhs the right-hand operand
+  //! @return the bitwise OR of the operands
+  friend constexpr FixedInt operator|(const FixedInt &lhs, const FixedInt &rhs)
+  {
+    FixedInt result;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      result.limbs[i] = lhs.limbs[i] | rhs.limbs[i];
+    }
+    return result;
+  }
+
+  //! Bitwise exclusive OR operator.
+  //!
+  //! @param lhs the left-hand operand
+  //! @param rhs the right-hand operand
+  //! @return the bitwise exclusive OR of the operands
+  friend constexpr FixedInt operator^(const FixedInt &lhs, const FixedInt &rhs)
+  {
+    FixedInt result;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      result.limbs[i] = lhs.limbs[i] ^ rhs.limbs[i];
+    }
+    return result;
+  }
+
+  //! Bitwise complement operator.
+  //!
+  //! @return the value with all `Bits` bits inverted
+  constexpr FixedInt operator~() const
+  {
+    FixedInt result;
+    #pragma GCC unroll 64
+    for (size_t i = 0; i < LIMBS; ++i) {
+      result.limbs[i] = ~limbs[i];
+    }
+    return result;
+  }
+
+  //! Compound assignment forms of the operators above.
+  constexpr FixedInt &operator+=(const FixedInt &rhs) { return *this = *this + rhs; }
+  constexpr FixedInt &operator-=(const FixedInt &rhs) { return *this = *this - rhs; }
+  constexpr FixedInt &operator*=(const FixedInt &rhs) { return *this = *this * rhs; }
+  constexpr FixedInt &operator/=(const FixedInt &rhs) { return *this = *this / rhs; }
+  constexpr FixedInt &operator%=(const FixedInt &rhs) { return *this = *this % rhs; }
+  constexpr FixedInt &operator<<=(unsigned n) { return *this = *this << n; }
+  constexpr FixedInt &operator>>=(unsigned n) { return *this = *this >> n; }
+  constexpr FixedInt &operator&=(const FixedInt &rhs) { return *this = *this & rhs; }
+  constexpr FixedInt &operator|=(const FixedInt &rhs) { return *this = *this | rhs; }
+  constexpr FixedInt &operator^=(const FixedInt &rhs) { return *this = *this ^ rhs; }
+
+  //! Compare two values.
+  //!
+  //! @param rhs the right-hand operand
+  //! @return negative if this value is less than `rhs`, 0 if they are
+  //!         equal, positive if this value is greater
+  constexpr int compare(const FixedInt &rhs) const
+  {
+    #pragma GCC unroll 64
+    for (size_t i = LIMBS; i > 0; --i) {
+      if (limbs[i - 1] != rhs.limbs[i - 1]) {
+        return limbs[i - 1] < rhs.limbs[i - 1] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  friend constexpr bool operator==(const FixedInt &lhs, const FixedInt &rhs) { return lhs.compare(rhs) == 0; }
+  friend constexpr bool operator!=(const FixedInt &lhs, const FixedInt &rhs) { return lhs.compare(rhs) != 0; }
+  friend constexpr bool operator<(const FixedInt &lhs, const FixedInt &rhs)  { return lhs.compare(rhs) < 0; }
+  friend constexpr bool operator<=(const FixedInt &lhs, const FixedInt &rhs) { return lhs.compare(rhs) <= 0; }
+  friend constexpr bool operator>(const FixedInt &lhs, const FixedInt &rhs)  { return lhs.compare(rhs) > 0; }
+  friend constexpr bool operator>=(const FixedInt &lhs, const FixedInt &rhs) { return lhs.compare(rhs) >= 0; }
+};
+
+// Mixed FixedInt and BigInt operands. The BigInt operand is a template
+// parameter restricted to BigInt, so that e.g. `x + 1` for a FixedInt x
+// still means FixedInt addition rather than being ambiguous (1 converts
+// implicitly to both types).
+
+//! Enables a FixedInt/BigInt operator template if `T` is BigInt.
+template <typename T>
+using enable_if_bigint = typename std::enable_if<std::is_same<T, BigInt>::value, int>::type;
+
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator+(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() + rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator+(const T &lhs, const FixedInt<Bits> &rhs) { return lhs + rhs.to_bigint(); }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator-(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() - rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator-(const T &lhs, const FixedInt<Bits> &rhs) { return lhs - rhs.to_bigint(); }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator*(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() * rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator*(const T &lhs, const FixedInt<Bits> &rhs) { return lhs * rhs.to_bigint(); }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator/(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() / rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator/(const T &lhs, const FixedInt<Bits> &rhs) { return lhs / rhs.to_bigint(); }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator%(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() % rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator%(const T &lhs, const FixedInt<Bits> &rhs) { return lhs % rhs.to_bigint(); }
+
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator&(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() & rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator&(const T &lhs, const FixedInt<Bits> &rhs) { return lhs & rhs.to_bigint(); }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator|(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() | rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator|(const T &lhs, const FixedInt<Bits> &rhs) { return lhs | rhs.to_bigint(); }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator^(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint() ^ rhs; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+BigInt operator^(const T &lhs, const FixedInt<Bits> &rhs) { return lhs ^ rhs.to_bigint(); }
+
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator==(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint().compare(rhs) == 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator==(const T &lhs, const FixedInt<Bits> &rhs) { return lhs.compare(rhs.to_bigint()) == 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator!=(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint().compare(rhs) != 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator!=(const T &lhs, const FixedInt<Bits> &rhs) { return lhs.compare(rhs.to_bigint()) != 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator<(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint().compare(rhs) < 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator<(const T &lhs, const FixedInt<Bits> &rhs) { return lhs.compare(rhs.to_bigint()) < 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator<=(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint().compare(rhs) <= 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator<=(const T &lhs, const FixedInt<Bits> &rhs) { return lhs.compare(rhs.to_bigint()) <= 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator>(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint().compare(rhs) > 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator>(const T &lhs, const FixedInt<Bits> &rhs) { return lhs.compare(rhs.to_bigint()) > 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator>=(const FixedInt<Bits> &lhs, const T &rhs) { return lhs.to_bigint().compare(rhs) >= 0; }
+template <unsigned Bits, typename T, enable_if_bigint<T> = 0>
+bool operator>=(const T &lhs, const FixedInt<Bits> &rhs) { return lhs.compare(rhs.to_bigint()) >= 0; }
+
+// The characters of a `_big` literal, in an array with static storage
+// duration, which (unlike a local array) a constant expression can
+// refer to.
+template <char... Chars>
+constexpr char big_literal_chars[] = { Chars... };
+
+//! Integer literal suffix for constants of any size, e.g.
+//! `123456789012345678901234567890_big` or `0xffff'ffff'ffff'ffff'ffff_big`
+//! (any of the forms accepted by `FixedInt::from_literal`). The literal
+//! is parsed at compile time, and its value is a FixedInt of the fewest
+//! limbs that hold it, so a table of such constants is built into the
+//! binary rather than parsed at startup. The constants can be combined
+//! with the `constexpr` FixedInt operations and with BigInt values, and
+//! convert explicitly to BigInt (by copying their limbs). Like the
+//! value of any FixedInt, a literal is unsigned: `-5_big` wraps around
+//! to `2^64 - 5`, and a negative BigInt constant is `-BigInt(5_big)`.
+template <char... Chars>
+constexpr auto operator""_big()
+{
+  // parse with room for 4 bits per character (enough for any base),
+  // then keep only the limbs that are needed
+  constexpr std::string_view str(big_literal_chars<Chars...>, sizeof...(Chars));
+  constexpr auto wide = FixedInt<64 * (4 * sizeof...(Chars) / 64 + 1)>::from_literal(str);
+  constexpr unsigned limbs = wide.bit_length() > 64 ? (wide.bit_length() + 63) / 64 : 1;
+  return FixedInt<64 * limbs>(wide);
+}
+
+#endif // FIXED_INT_H
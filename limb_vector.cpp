@@ -0,0 +1,93 @@
+#include <cstring>
+#include "limb_vector.h"
+
+thread_local std::pmr::memory_resource *limb_resource_override = nullptr;
+
+LimbVector::LimbVector(const LimbVector &other)
+  : res(limb_resource()), len(0), cap(INLINE_LIMBS)
+{
+  reserve(other.len);
+  memcpy(data(), other.data(), other.len * sizeof(uint64_t));
+  len = other.len;
+}
+
+LimbVector::LimbVector(LimbVector &&other) noexcept
+  : res(other.res), len(other.len), cap(other.cap)
+{
+  if (other.cap > INLINE_LIMBS) {
+    heap = other.heap;
+    other.cap = INLINE_LIMBS;
+  } else {
+    memcpy(inline_limbs, other.inline_limbs, len * sizeof(uint64_t));
+  }
+  other.len = 0;
+}
+
+LimbVector::~LimbVector()
+{
+  release();
+}
+
+LimbVector &LimbVector::operator=(const LimbVector &rhs)
+{
+  if (this != &rhs) {
+    len = 0;
+    reserve(rhs.len);
+    memcpy(data(), rhs.data(), rhs.len * sizeof(uint64_t));
+    len = rhs.len;
+  }
+  return *this;
+}
+
+LimbVector &LimbVector::operator=(LimbVector &&rhs) noexcept
+{
+  if (this == &rhs) {
+    return *this;
+  }
+  if (rhs.cap > INLINE_LIMBS && *res == *rhs.res) {
+    release();
+    heap = rhs.heap;
+    cap = rhs.cap;
+    rhs.cap = INLINE_LIMBS;
+  } else {
+    // rhs is inline (so it fits in whatever storage this object has),
+    // or its storage can't be handed over to this object's resource
+    len = 0;
+    reserve(rhs.len);
+    memcpy(data(), rhs.data(), rhs.len * sizeof(uint64_t));
+  }
+  len = rhs.len;
+  rhs.len = 0;
+  return *this;
+}
+
+void LimbVector::release()
+{
+  if (cap > INLINE_LIMBS) {
+    res->deallocate(heap, cap * sizeof(uint64_t), alignof(uint64_t));
+  }
+}
+
+void LimbVector::reserve(size_t n)
+{
+  if (n <= cap) {
+    return;
+  }
+  uint64_t *fresh = static_cast<uint64_t *>(res->allocate(n * sizeof(uint64_t), alignof(uint64_t)));
+  memcpy(fresh, data(), len * sizeof(uint64_t));
+  release();
+  heap = fresh;
+  cap = n;
+}
+
+void LimbVector::resize(size_t n, uint64_t val)
+{
+  if (n > cap) {
+    reserve(n > 2 * cap ? n : 2 * cap);
+  }
+  uint64_t *limbs = data();
+  for (size_t i = len; i < n; ++i) {
+    limbs[i] = val;
+  }
+  len = n;
+}
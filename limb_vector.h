@@ -0,0 +1,185 @@
+#ifndef LIMB_VECTOR_H
+#define LIMB_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+//! @file
+//! Storage for the limbs of a BigInt: a vector-like container with
+//! room for a few limbs inside the object itself, and a read-only view
+//! type used to expose the limbs without committing to a container.
+//! Heap storage comes from a `std::pmr::memory_resource`, selected per
+//! thread with `LimbResourceScope` (by default, the resource returned
+//! by `std::pmr::get_default_resource()`).
+
+//! The memory resource chosen for the calling thread by the innermost
+//! active `LimbResourceScope`, or null if there is none.
+extern thread_local std::pmr::memory_resource *limb_resource_override;
+
+//! Return the memory resource that newly created limb vectors (and
+//! therefore BigInt values) on the calling thread allocate from.
+inline std::pmr::memory_resource *limb_resource()
+{
+  return limb_resource_override ? limb_resource_override : std::pmr::get_default_resource();
+}
+
+//! While an object of this class exists, BigInt values created on the
+//! same thread allocate their limbs from the given memory resource,
+//! e.g. a `std::pmr::monotonic_buffer_resource` arena that backs all
+//! the temporaries of a computation and is released in one go. The
+//! resource must outlive every value created in the scope; copy
+//! results that are needed afterwards outside the scope (a copy uses
+//! the resource current at the time it is made). Scopes nest.
+class LimbResourceScope {
+private:
+  std::pmr::memory_resource *prev;
+
+  LimbResourceScope(const LimbResourceScope &) = delete;
+  LimbResourceScope &operator=(const LimbResourceScope &) = delete;
+
+public:
+  //! Constructor.
+  //!
+  //! @param resource the memory resource to allocate limbs from
+  explicit LimbResourceScope(std::pmr::memory_resource *resource)
+    : prev(limb_resource_override)
+  {
+    limb_resource_override = resource;
+  }
+
+  //! Destructor: restores the previously selected resource.
+  ~LimbResourceScope() { limb_resource_override = prev; }
+};
+
+//! Read-only view of a contiguous sequence of `uint64_t` limbs
+//! (a minimal stand-in for C++20's `std::span<const uint64_t>`).
+//! A view does not own its limbs; it is invalidated by any change to
+//! the object it was obtained from.
+class LimbSpan {
+private:
+  const uint64_t *ptr;
+  size_t len;
+
+public:
+  typedef const uint64_t *iterator;
+
+  //! Constructor.
+  //!
+  //! @param data pointer to the first limb
+  //! @param size number of limbs
+  LimbSpan(const uint64_t *data, size_t size) : ptr(data), len(size) { }
+
+  const uint64_t *data() const { return ptr; }
+  size_t size() const { return len; }
+  bool empty() const { return len == 0; }
+  iterator begin() const { return ptr; }
+  iterator end() const { return ptr + len; }
+  const uint64_t &operator[](size_t i) const { return ptr[i]; }
+  const uint64_t &back() const { return ptr[len - 1]; }
+};
+
+//! Vector of `uint64_t` limbs with small-buffer optimization: up to
+//! `INLINE_LIMBS` limbs are stored inside the object, and only longer
+//! sequences are allocated from the vector's memory resource. The
+//! interface is the subset of `std::vector` that BigInt needs. Growing
+//! past the inline capacity moves the limbs to the heap; shrinking
+//! never moves them back (the capacity is kept for reuse).
+//!
+//! As with the `std::pmr` containers, the memory resource is fixed when
+//! the vector is created: a copy uses the calling thread's current
+//! resource, a move keeps the source's, and assignment never changes
+//! the resource of the destination (a move between vectors with
+//! different resources copies the limbs).
+class LimbVector {
+public:
+  //! Number of limbs stored without a heap allocation.
+  static const size_t INLINE_LIMBS = 4;
+
+private:
+  std::pmr::memory_resource *res;
+  size_t len;
+  size_t cap;  // INLINE_LIMBS while the limbs are stored inline
+  union {
+    uint64_t inline_limbs[INLINE_LIMBS];
+    uint64_t *heap;
+  };
+
+  // Release the heap storage, if any (the contents are left as they
+  // are, so the caller must reset cap or replace heap).
+  void release();
+
+public:
+  //! Constructor: an empty vector.
+  //!
+  //! @param resource the memory resource to allocate limbs from
+  explicit LimbVector(std::pmr::memory_resource *resource = limb_resource())
+    : res(resource), len(0), cap(INLINE_LIMBS) { }
+
+  //! Copy constructor. The copy allocates from the calling thread's
+  //! current resource, not from that of `other`.
+  LimbVector(const LimbVector &other);
+
+  //! Move constructor. Heap storage is taken over from `other`,
+  //! which is left empty.
+  LimbVector(LimbVector &&other) noexcept;
+
+  //! Destructor.
+  ~LimbVector();
+
+  //! Copy assignment. Reuses the existing storage when it is large
+  //! enough.
+  LimbVector &operator=(const LimbVector &rhs);
+
+  //! Move assignment. Heap storage is taken over from `rhs`, which is
+  //! left empty, if both vectors use the same memory resource;
+  //! otherwise the limbs are copied. Running out of memory while
+  //! copying terminates the program, to keep moves non-throwing.
+  LimbVector &operator=(LimbVector &&rhs) noexcept;
+
+  //! Return the memory resource this vector allocates from.
+  std::pmr::memory_resource *resource() const { return res; }
+
+  uint64_t *data() { return cap > INLINE_LIMBS ? heap : inline_limbs; }
+  const uint64_t *data() const { return cap > INLINE_LIMBS ? heap : inline_limbs; }
+  size_t size() const { return len; }
+  size_t capacity() const { return cap; }
+  bool empty() const { return len == 0; }
+
+  uint64_t *begin() { return data(); }
+  uint64_t *end() { return data() + len; }
+  const uint64_t *begin() const { return data(); }
+  const uint64_t *end() const { return data() + len; }
+
+  uint64_t &operator[](size_t i) { return data()[i]; }
+  const uint64_t &operator[](size_t i) const { return data()[i]; }
+  uint64_t &back() { return data()[len - 1]; }
+  const uint64_t &back() const { return data()[len - 1]; }
+
+  //! Make sure there is room for at least `n` limbs without further
+  //! allocation. The contents are unchanged.
+  void reserve(size_t n);
+
+  //! Change the number of limbs to `n`; added limbs are set to `val`.
+  void resize(size_t n, uint64_t val = 0);
+
+  //! Append a limb.
+  void push_back(uint64_t val)
+  {
+    if (len == cap) {
+      reserve(2 * cap);
+    }
+    data()[len++] = val;
+  }
+
+  //! Remove the last limb.
+  void pop_back() { --len; }
+
+  //! Remove all limbs (the capacity is kept).
+  void clear() { len = 0; }
+
+  //! Return a read-only view of the limbs.
+  LimbSpan view() const { return LimbSpan(data(), len); }
+};
+
+#endif // LIMB_VECTOR_H